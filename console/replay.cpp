@@ -0,0 +1,325 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/server.hpp>
+
+BC_USE_LIBBITCOIN_MAIN
+
+using namespace bc;
+using namespace bc::server;
+
+typedef std::chrono::steady_clock replay_clock;
+
+#define BS_REPLAY_USAGE \
+    "Usage: bs-replay [options] <request-log>\n" \
+    "Replays a log recorded with the server record_file setting.\n\n" \
+    "  -e <endpoint>     The query endpoint, defaults to " \
+        "'tcp://127.0.0.1:9091'.\n" \
+    "  -s <speed>        The speed relative to the recording, 0 for " \
+        "maximum, defaults to 1.\n" \
+    "  -c <concurrency>  The maximum requests in flight, at least 1, " \
+        "defaults to 16.\n" \
+    "  -t <seconds>      The reply timeout, at least 1, defaults to 30.\n"
+
+static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char* quantile_names[] = { "p50", "p90", "p99", "p99.9" };
+
+struct replay_settings
+{
+    std::string endpoint = "tcp://127.0.0.1:9091";
+    std::string file;
+    double speed = 1.0;
+    size_t concurrency = 16;
+    uint32_t timeout_seconds = 30;
+};
+
+struct command_results
+{
+    uint64_t requests = 0;
+    uint64_t replies = 0;
+    uint64_t errors = 0;
+    uint64_t timeouts = 0;
+    std::shared_ptr<latency_histogram> latency =
+        std::make_shared<latency_histogram>();
+};
+
+struct in_flight
+{
+    std::string command;
+    replay_clock::time_point sent;
+};
+
+// Digits only, as the standard conversions accept signs, leading space and
+// trailing text. Counts are limited to nine digits so they fit 32 bits.
+static bool parse_count(const std::string& text, uint32_t& out)
+{
+    if (text.empty() || text.size() > 9 ||
+        text.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    out = static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+    return out > 0;
+}
+
+// A speed of zero replays at maximum speed.
+static bool parse_speed(const std::string& text, double& out)
+{
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+        return false;
+
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(out);
+}
+
+static bool parse(int argc, char* argv[], replay_settings& settings)
+{
+    uint32_t count;
+
+    for (auto arg = 1; arg < argc; ++arg)
+    {
+        const std::string option(argv[arg]);
+        const auto has_value = arg + 1 < argc;
+
+        if (option == "-e" && has_value)
+            settings.endpoint = argv[++arg];
+        else if (option == "-s" && has_value)
+        {
+            if (!parse_speed(argv[++arg], settings.speed))
+                return false;
+        }
+        else if (option == "-c" && has_value)
+        {
+            if (!parse_count(argv[++arg], count))
+                return false;
+
+            settings.concurrency = count;
+        }
+        else if (option == "-t" && has_value)
+        {
+            if (!parse_count(argv[++arg], settings.timeout_seconds))
+                return false;
+        }
+        else if (!option.empty() && option[0] != '-' && settings.file.empty())
+            settings.file = option;
+        else
+            return false;
+    }
+
+    return !settings.file.empty();
+}
+
+static uint64_t microseconds(replay_clock::duration elapsed)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        elapsed).count();
+}
+
+static void send(czmqpp::socket& socket, const recorded_request& request,
+    uint32_t id)
+{
+    // [ COMMAND ] [ ID ] [ DATA ], the router adds the client identity.
+    czmqpp::message message;
+    message.append(data_chunk(request.command.begin(),
+        request.command.end()));
+    message.append(to_chunk(to_little_endian(id)));
+    message.append(request.data);
+    message.send(socket);
+}
+
+static void report(const std::map<std::string, command_results>& results,
+    double seconds, std::ostream& output)
+{
+    uint64_t replies = 0;
+    output << std::left << std::setw(40) << "command" << std::right
+        << std::setw(10) << "requests" << std::setw(10) << "replies"
+        << std::setw(8) << "errors" << std::setw(9) << "timeouts";
+
+    for (const auto name: quantile_names)
+        output << std::setw(10) << name;
+
+    output << std::setw(10) << "max" << "\n";
+
+    for (const auto& item: results)
+    {
+        const auto& result = item.second;
+        replies += result.replies;
+        output << std::left << std::setw(40) << item.first << std::right
+            << std::setw(10) << result.requests
+            << std::setw(10) << result.replies
+            << std::setw(8) << result.errors
+            << std::setw(9) << result.timeouts;
+
+        for (const auto quantile: quantiles)
+            output << std::setw(10) << result.latency->quantile(quantile);
+
+        output << std::setw(10) << result.latency->maximum() << "\n";
+    }
+
+    output << "\nLatencies in microseconds. " << replies << " replies in "
+        << std::fixed << std::setprecision(3) << seconds << " seconds ("
+        << std::setprecision(1) << (seconds > 0 ? replies / seconds : 0)
+        << " per second)." << std::endl;
+}
+
+static int replay(const replay_settings& settings, std::ostream& output,
+    std::ostream& error)
+{
+    request_log_reader reader(settings.file);
+    if (!reader.valid())
+    {
+        error << "Not a request log: " << settings.file << std::endl;
+        return console_result::failure;
+    }
+
+    czmqpp::context context;
+    czmqpp::socket socket(context, ZMQ_DEALER);
+    if (socket.connect(settings.endpoint) == -1)
+    {
+        error << "Failed to connect to " << settings.endpoint << std::endl;
+        return console_result::failure;
+    }
+
+    const auto timeout = std::chrono::seconds(settings.timeout_seconds);
+    std::map<std::string, command_results> results;
+    std::unordered_map<uint32_t, in_flight> pending;
+    uint32_t next_id = 0;
+
+    recorded_request next;
+    auto more = reader.read(next);
+    const auto start = replay_clock::now();
+
+    // The time a recorded request is due, scaled by the speed.
+    const auto due = [&settings, &start](const recorded_request& request)
+    {
+        const auto offset = settings.speed == 0 ? 0.0 :
+            request.microseconds / settings.speed;
+        return start + std::chrono::microseconds(
+            static_cast<int64_t>(offset));
+    };
+
+    while (more || !pending.empty())
+    {
+        auto now = replay_clock::now();
+
+        // Send all requests that are due, within the concurrency limit.
+        while (more && pending.size() < settings.concurrency &&
+            due(next) <= now)
+        {
+            const auto id = next_id++;
+            send(socket, next, id);
+            pending[id] = { next.command, now };
+            ++results[next.command].requests;
+            more = reader.read(next);
+        }
+
+        // Wait for a reply, or until the next request is due.
+        auto wait = std::chrono::milliseconds(100);
+        if (more && pending.size() < settings.concurrency)
+            wait = std::min(wait, std::chrono::duration_cast<
+                std::chrono::milliseconds>(due(next) - now));
+
+        czmqpp::poller poller(socket);
+        const auto which = poller.wait(
+            wait.count() < 0 ? 0 : static_cast<int>(wait.count()));
+
+        if (which == socket)
+        {
+            // [ COMMAND ] [ ID ] [ DATA ]
+            czmqpp::message message;
+            message.receive(socket);
+            const auto& parts = message.parts();
+            if (parts.size() == 3 && parts[1].size() == sizeof(uint32_t))
+            {
+                const auto id = from_little_endian_unsafe<uint32_t>(
+                    parts[1].begin());
+                const auto it = pending.find(id);
+
+                // Subscription notifications do not match a request.
+                if (it != pending.end())
+                {
+                    auto& result = results[it->second.command];
+                    ++result.replies;
+                    result.latency->record(
+                        microseconds(replay_clock::now() - it->second.sent));
+
+                    const auto& data = parts[2];
+                    if (data.size() >= sizeof(uint32_t) &&
+                        from_little_endian_unsafe<uint32_t>(data.begin()))
+                        ++result.errors;
+
+                    pending.erase(it);
+                }
+            }
+        }
+
+        // Requests with no reply are counted and forgotten.
+        now = replay_clock::now();
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            if (now - it->second.sent > timeout)
+            {
+                ++results[it->second.command].timeouts;
+                it = pending.erase(it);
+                continue;
+            }
+
+            ++it;
+        }
+    }
+
+    const auto elapsed = replay_clock::now() - start;
+    report(results, microseconds(elapsed) / 1e6, output);
+    socket.destroy(context);
+    return console_result::okay;
+}
+
+/**
+ * Replay a recorded request log against a server and report per command
+ * throughput and latency.
+ * @param argc  The number of elements in the argv array.
+ * @param argv  The array of arguments, including the process.
+ * @return      The numeric result to return via console exit.
+ */
+int bc::main(int argc, char* argv[])
+{
+    bc::set_utf8_stdio();
+
+    replay_settings settings;
+    if (!parse(argc, argv, settings))
+    {
+        bc::cerr << BS_REPLAY_USAGE;
+        return console_result::failure;
+    }
+
+    return replay(settings, bc::cout, bc::cerr);
+}
@@ -15,12 +15,31 @@
  */
 
 #include <bitcoin/node.hpp>
+#include <bitcoin/server/bloom_filter.hpp>
+#include <bitcoin/server/callback_guard.hpp>
+#include <bitcoin/server/client_queue.hpp>
+#include <bitcoin/server/count_min_sketch.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/dispatch.hpp>
+#include <bitcoin/server/header_store.hpp>
+#include <bitcoin/server/hot_address_cache.hpp>
+#include <bitcoin/server/latency_histogram.hpp>
 #include <bitcoin/server/message.hpp>
+#include <bitcoin/server/negative_filters.hpp>
+#include <bitcoin/server/notification_bus.hpp>
 #include <bitcoin/server/publisher.hpp>
+#include <bitcoin/server/replay_buffer.hpp>
+#include <bitcoin/server/reply_tracker.hpp>
+#include <bitcoin/server/request_log.hpp>
+#include <bitcoin/server/request_logger.hpp>
+#include <bitcoin/server/request_scheduler.hpp>
+#include <bitcoin/server/ring_buffer.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/siphash.hpp>
+#include <bitcoin/server/statistics.hpp>
 #include <bitcoin/server/subscribe_manager.hpp>
+#include <bitcoin/server/tracer.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
 #include <bitcoin/server/version.hpp>
 #include <bitcoin/server/worker.hpp>
 #include <bitcoin/server/config/configuration.hpp>
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_BLOOM_FILTER_HPP
+#define LIBBITCOIN_SERVER_BLOOM_FILTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/siphash.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A blocked Bloom filter, sized for a number of elements and a target
+ * false positive rate.
+ *
+ * All bits of a key fall within one 64 byte block, so a probe touches a
+ * single cache line. Keys are hashed with a random per-process key, so
+ * false positives cannot be chosen in advance. Inserts and probes are
+ * lock-free and may run concurrently. A zero element filter is disabled
+ * and contains everything.
+ */
+class BCS_API bloom_filter
+{
+public:
+    bloom_filter(size_t elements, double false_positive_rate);
+
+    bloom_filter(const bloom_filter&) = delete;
+    void operator=(const bloom_filter&) = delete;
+
+    void insert(data_slice key);
+
+    /// False only if the key has never been inserted.
+    bool contains(data_slice key) const;
+
+    bool enabled() const;
+    size_t size_bytes() const;
+    size_t hash_count() const;
+    uint64_t inserted() const;
+
+    /// The expected false positive rate at the current element count.
+    double false_positive_rate() const;
+
+private:
+    static constexpr size_t block_bits = 512;
+    static constexpr size_t block_words = block_bits / 64;
+
+    const size_t blocks_;
+    const size_t hashes_;
+    const std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    siphash_key block_key_;
+    siphash_key bit_key_;
+    std::atomic<uint64_t> inserted_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
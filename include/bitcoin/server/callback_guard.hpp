@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CALLBACK_GUARD_HPP
+#define LIBBITCOIN_SERVER_CALLBACK_GUARD_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Protects an object from the callbacks it has bound to itself and handed
+ * to another thread pool, such as blockchain queries, which may complete
+ * after the object is destroyed.
+ *
+ * A wrapped callback runs only while the guard is open. Closing the guard
+ * waits for wrapped callbacks that are running to return, and makes those
+ * yet to run do nothing, so close it first in the destructor of the owner.
+ * Callbacks must not block. This class is thread safe.
+ */
+class callback_guard
+{
+public:
+    template <typename Handler>
+    struct guarded
+    {
+        std::weak_ptr<void> open;
+        Handler handler;
+
+        template <typename... Args>
+        void operator()(Args&&... args) const
+        {
+            const auto running = open.lock();
+            if (running)
+                handler(std::forward<Args>(args)...);
+        }
+    };
+
+    callback_guard()
+      : open_(std::make_shared<bool>(true)), weak_(open_)
+    {
+    }
+
+    ~callback_guard()
+    {
+        close();
+    }
+
+    callback_guard(const callback_guard&) = delete;
+    void operator=(const callback_guard&) = delete;
+
+    /// Run the handler only while the guard is open.
+    template <typename Handler>
+    guarded<Handler> wrap(Handler handler) const
+    {
+        return { weak_, std::move(handler) };
+    }
+
+    /// Disable wrapped callbacks and wait for running ones to return, call
+    /// from the owner's thread only.
+    void close()
+    {
+        open_.reset();
+
+        while (!weak_.expired())
+            std::this_thread::yield();
+
+        // Pairs with the release of the last running callback.
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+private:
+    // Wrapped from running callbacks, so only the immutable weak pointer
+    // is read by wrap.
+    std::shared_ptr<void> open_;
+    const std::weak_ptr<void> weak_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CLIENT_QUEUE_HPP
+#define LIBBITCOIN_SERVER_CLIENT_QUEUE_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <boost/date_time.hpp>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Bounded outbound message queues, one per query client (ROUTER identity).
+ *
+ * Replies are never dropped. Notifications are dropped oldest first once a
+ * client exceeds its configured message or byte limit. A client that accepts
+ * nothing for longer than the slow client timeout, or whose peer is lost, is
+ * disconnected: its queue is discarded and the disconnect handler invoked.
+ * zeromq cannot close one peer of a router socket, so the connection itself
+ * stays open. A later request from the client is answered as from a new
+ * client, with its subscriptions gone.
+ *
+ * This class is not thread safe, it is owned by the request_worker thread.
+ */
+class BCS_API client_queue
+{
+public:
+    typedef std::function<void (const data_chunk&)> disconnect_handler;
+    typedef std::function<void (const czmqpp::message&)> sent_handler;
+    typedef std::function<boost::posix_time::ptime ()> clock;
+
+    struct depth
+    {
+        size_t messages;
+        size_t bytes;
+        size_t dropped;
+    };
+
+    typedef std::map<data_chunk, depth> depth_map;
+
+    /// The clock is the time of the system unless replaced, for tests.
+    client_queue(const settings& settings,
+        clock now=&client_queue::universal_time);
+
+    static boost::posix_time::ptime universal_time();
+
+    /// Set the handler invoked when a slow client is disconnected.
+    void set_disconnect_handler(disconnect_handler handler);
+
+    /// Set the handler invoked as each message is written to the socket.
+    void set_sent_handler(sent_handler handler);
+
+    /// Queue a fully-framed outgoing message (as read from the send queue),
+    /// a message without a destination cannot be routed and is dropped.
+    void enqueue(const czmqpp::message& message);
+
+    /// Send as much as each client will accept without blocking.
+    void flush(czmqpp::socket& socket);
+
+    /// True if any client has queued messages.
+    bool pending() const;
+
+    /// The current queue depth of each client with queued messages.
+    depth_map depths() const;
+
+private:
+    struct entry
+    {
+        czmqpp::message message;
+        size_t bytes;
+        bool notification;
+    };
+
+    struct client
+    {
+        std::deque<entry> entries;
+        size_t bytes = 0;
+        size_t dropped = 0;
+        boost::posix_time::ptime last_progress;
+    };
+
+    typedef std::map<data_chunk, client> client_map;
+
+    void enforce_limits(const data_chunk& origin, client& queue);
+    bool flush(czmqpp::socket& socket, client& queue);
+    void disconnect(client_map::iterator it);
+
+    const clock now_;
+    client_map clients_;
+    disconnect_handler disconnect_handler_;
+    sent_handler sent_handler_;
+    const settings& settings_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -21,6 +21,8 @@
 #define LIBBITCOIN_SERVER_SETTINGS_HPP
 
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/node.hpp>
 #include <bitcoin/server/define.hpp>
@@ -33,6 +35,8 @@ namespace server {
 #define SERVER_HEARTBEAT_ENDPOINT               config::endpoint{"tcp://*:9092"}
 #define SERVER_BLOCK_PUBLISH_ENDPOINT           config::endpoint{"tcp://*:9093"}
 #define SERVER_TRANSACTION_PUBLISH_ENDPOINT     config::endpoint{"tcp://*:9094"}
+#define SERVER_RAW_BLOCK_PUBLISH_ENDPOINT       config::endpoint{"tcp://*:9095"}
+#define SERVER_STATS_ENDPOINT                   config::endpoint{"tcp://127.0.0.1:9096"}
 #define SERVER_PUBLISHER_ENABLED                true
 #define SERVER_QUERIES_ENABLED                  true
 #define SERVER_LOG_REQUESTS                     false
@@ -43,6 +47,37 @@ namespace server {
 #define SERVER_CERTIFICATE_FILE                 boost::filesystem::path()
 #define SERVER_CLIENT_CERTIFICATES_PATH         boost::filesystem::path()
 #define SERVER_WHITELISTS                       config::authority::list()
+#define SERVER_OUTBOUND_QUEUE_MESSAGES          1000
+#define SERVER_OUTBOUND_QUEUE_BYTES             10000000
+#define SERVER_SLOW_CLIENT_TIMEOUT_SECONDS      60
+#define SERVER_TRANSACTION_CACHE_CAPACITY       10000
+#define SERVER_NOTIFICATION_BUS_CAPACITY        1024
+#define SERVER_PUBLISHER_TOPICS                 false
+#define SERVER_PUBLISHER_SEQUENCE               false
+#define SERVER_PUBLISHER_REPLAY_CAPACITY        1000
+#define SERVER_PUBLISHER_COMPACT_BLOCKS         false
+#define SERVER_PUBLISHER_COMPACT_PUBLISHED_CAPACITY 50000
+#define SERVER_PUBLISHER_DISCONNECTS            false
+#define SERVER_PUBLISHER_RAW_BLOCKS             false
+#define SERVER_HOT_ADDRESS_CAPACITY             100
+#define SERVER_NEGATIVE_FILTER_ADDRESSES        0
+#define SERVER_NEGATIVE_FILTER_TRANSACTIONS     0
+#define SERVER_NEGATIVE_FILTER_SPENDS           0
+#define SERVER_NEGATIVE_FILTER_FALSE_POSITIVE_RATE 0.01
+#define SERVER_STATS_ENABLED                    false
+#define SERVER_TRACE_SAMPLE_INTERVAL            0
+#define SERVER_TRACE_FILE                       boost::filesystem::path("trace.json")
+#define SERVER_RECORD_FILE                      boost::filesystem::path()
+#define SERVER_QUERY_NORMAL_CONCURRENCY         16
+#define SERVER_QUERY_EXPENSIVE_CONCURRENCY      4
+#define SERVER_QUERY_DELAY_TARGET_MILLISECONDS  100
+#define SERVER_QUERY_DELAY_INTERVAL_MILLISECONDS 1000
+#define SERVER_QUERY_RATE_LIMIT                 0
+#define SERVER_QUERY_RATE_BURST                 20
+#define SERVER_QUERY_CLIENT_WEIGHTS             std::vector<std::string>()
+#define SERVER_LOG_REQUEST_SAMPLE_INTERVAL      1
+#define SERVER_LOG_REQUEST_CAPACITY             65536
+#define SERVER_HEADER_STORE_ENABLED             true
 
 struct BCS_API settings
 {
@@ -50,6 +85,8 @@ struct BCS_API settings
     config::endpoint heartbeat_endpoint;
     config::endpoint block_publish_endpoint;
     config::endpoint transaction_publish_endpoint;
+    config::endpoint raw_block_publish_endpoint;
+    config::endpoint stats_endpoint;
     bool publisher_enabled;
     bool queries_enabled;
     bool log_requests;
@@ -60,6 +97,37 @@ struct BCS_API settings
     boost::filesystem::path certificate_file;
     boost::filesystem::path client_certificates_path;
     config::authority::list whitelists;
+    uint32_t outbound_queue_messages;
+    uint32_t outbound_queue_bytes;
+    uint32_t slow_client_timeout_seconds;
+    uint32_t transaction_cache_capacity;
+    uint32_t notification_bus_capacity;
+    bool publisher_topics;
+    bool publisher_sequence;
+    uint32_t publisher_replay_capacity;
+    bool publisher_compact_blocks;
+    uint32_t publisher_compact_published_capacity;
+    bool publisher_disconnects;
+    bool publisher_raw_blocks;
+    uint32_t hot_address_capacity;
+    uint32_t negative_filter_addresses;
+    uint32_t negative_filter_transactions;
+    uint32_t negative_filter_spends;
+    double negative_filter_false_positive_rate;
+    bool stats_enabled;
+    uint32_t trace_sample_interval;
+    boost::filesystem::path trace_file;
+    boost::filesystem::path record_file;
+    uint32_t query_normal_concurrency;
+    uint32_t query_expensive_concurrency;
+    uint32_t query_delay_target_milliseconds;
+    uint32_t query_delay_interval_milliseconds;
+    uint32_t query_rate_limit;
+    uint32_t query_rate_burst;
+    std::vector<std::string> query_client_weights;
+    uint32_t log_request_sample_interval;
+    uint32_t log_request_capacity;
+    bool header_store_enabled;
 
     asio::duration polling_interval() const
     {
@@ -77,6 +145,11 @@ struct BCS_API settings
     {
         return asio::duration(0, subscription_expiration_minutes, 0);
     }
+
+    asio::duration slow_client_timeout() const
+    {
+        return asio::duration(0, 0, slow_client_timeout_seconds);
+    }
 };
 
 } // namespace server
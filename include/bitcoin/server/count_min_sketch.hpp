@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_COUNT_MIN_SKETCH_HPP
+#define LIBBITCOIN_SERVER_COUNT_MIN_SKETCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/siphash.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * An approximate frequency counter of fixed memory (count-min sketch).
+ *
+ * Estimates never undercount, and overcount by at most a small fraction of
+ * the total with high probability. Each row is keyed randomly per process,
+ * so that colliding keys cannot be chosen in advance. All counts are halved
+ * periodically so that estimates reflect recent load. Not thread safe.
+ */
+class BCS_API count_min_sketch
+{
+public:
+    count_min_sketch(size_t width, size_t depth, uint64_t decay_interval);
+
+    /// Count one occurrence of the key, returns its new estimate.
+    uint32_t increment(data_slice key);
+
+    /// The estimated number of occurrences of the key.
+    uint32_t estimate(data_slice key) const;
+
+    /// True if the last increment halved all counts.
+    bool decayed() const;
+
+private:
+    size_t index(size_t row, data_slice key) const;
+    void decay();
+
+    const size_t width_;
+    const uint64_t decay_interval_;
+    std::vector<siphash_key> keys_;
+    std::vector<uint32_t> counts_;
+    uint64_t increments_;
+    bool decayed_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
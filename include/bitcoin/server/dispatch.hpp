@@ -36,6 +36,17 @@ enum console_result : int
     not_started = 1
 };
 
+class publisher;
+class request_worker;
+class server_node;
+class subscribe_manager;
+
+/**
+ * Attach the client-server API of the node to the query worker.
+ */
+void BCS_API attach_api(request_worker& worker, server_node& node,
+    subscribe_manager& subscriber, publisher& publish);
+
 /**
  * Dispatch from the command line.
  */
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_HEADER_STORE_HPP
+#define LIBBITCOIN_SERVER_HEADER_STORE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/callback_guard.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * The serialized headers of the chain, contiguous by height from genesis,
+ * so that a range of headers is answered with a single copy.
+ *
+ * The store is populated by walking the chain in the background after
+ * startup, in batches of parallel lookups, and follows reorganizations
+ * from the block notifications. Each
+ * header must link to the one below it, a header that does not is dropped
+ * along with its predecessor so that the walk reads the latter again. A
+ * range beyond the store is answerable only once the walk has reached the
+ * top of the chain. Destruction stops the walk and waits for a header read
+ * in progress. This class is thread safe.
+ */
+class BCS_API header_store
+{
+public:
+    static constexpr size_t header_size = 80;
+
+    header_store(const settings& settings);
+    ~header_store();
+
+    /// Walk the chain to populate the store, call once after start.
+    void load(blockchain::block_chain& chain);
+
+    /// Replace the headers above the fork point with the new blocks.
+    void reorganize(uint64_t fork_point,
+        const blockchain::block_chain::list& new_blocks);
+
+    /// Append the headers from the start height, up to count or the top of
+    /// the chain, to the buffer. False if the store cannot answer the range.
+    bool read(size_t start, size_t count, data_chunk& out) const;
+
+    /// The hash of the block at the height, false if not in the store.
+    bool block_hash(size_t height, hash_digest& out) const;
+
+    bool enabled() const;
+    bool ready() const;
+    size_t size() const;
+
+private:
+    struct batch;
+    typedef std::shared_ptr<batch> batch_ptr;
+
+    void handle_last_height(const code& ec, size_t last_height,
+        blockchain::block_chain& chain);
+    void load_batch(blockchain::block_chain& chain);
+    void handle_header(const code& ec, const chain::header& header,
+        size_t index, batch_ptr headers, blockchain::block_chain& chain);
+    void handle_batch(batch_ptr headers, blockchain::block_chain& chain);
+
+    // These require the mutex.
+    size_t stored() const;
+    bool append(size_t height, const chain::header& header);
+
+    const bool enabled_;
+    data_chunk headers_;
+
+    // The top of the chain at the last block notification, which the walk
+    // must reach before the store is ready.
+    size_t notified_top_;
+    std::atomic<bool> ready_;
+    std::atomic<bool> stopped_;
+    mutable std::mutex mutex_;
+
+    // Keeps walk callbacks from running on a destroyed object.
+    callback_guard guard_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_HOT_ADDRESS_CACHE_HPP
+#define LIBBITCOIN_SERVER_HOT_ADDRESS_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/count_min_sketch.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * The histories of the most queried addresses (top-K), with their
+ * serialized responses.
+ *
+ * Query frequency is estimated by a count-min sketch over address hashes,
+ * and only addresses estimated among the K most frequent are cached. An
+ * entry is invalidated whenever a transaction touching its address is
+ * accepted or confirmed (or a block containing one is disconnected), and is
+ * refilled by the next query. This class is thread safe.
+ */
+class BCS_API hot_address_cache
+{
+public:
+    typedef std::shared_ptr<const blockchain::block_chain::history>
+        history_ptr;
+
+    /// The history sources: the chain, or the chain and the memory pool.
+    enum class source
+    {
+        chain = 0,
+        pool = 1
+    };
+
+    struct result
+    {
+        history_ptr history;
+        data_chunk payload;
+    };
+
+    hot_address_cache(size_t capacity);
+
+    /// Count a query of the address, returns true if it is now hot.
+    bool record(const short_hash& hash);
+
+    /// Get the cached history, otherwise the generation to store against.
+    bool fetch(const short_hash& hash, source from, result& out,
+        uint64_t& generation);
+
+    /// Cache a history read from the database, ignored if the address has
+    /// been invalidated since the generation was obtained.
+    void store(const short_hash& hash, source from, uint64_t generation,
+        history_ptr history, const data_chunk& payload);
+
+    /// Invalidate the addresses of the transaction.
+    void invalidate(const transaction_analysis& tx);
+
+    bool empty() const;
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    static constexpr size_t sources = 2;
+
+    struct entry
+    {
+        uint32_t estimate;
+        uint64_t generation;
+        bool cached[sources];
+        result results[sources];
+    };
+
+    typedef std::unordered_map<short_hash, entry> entry_map;
+
+    void admit(const short_hash& hash, uint32_t estimate);
+    void invalidate(const wallet::payment_address& address);
+
+    const size_t capacity_;
+    count_min_sketch sketch_;
+    entry_map entries_;
+    uint32_t floor_;
+    uint64_t generation_;
+    std::atomic<size_t> size_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_LATENCY_HISTOGRAM_HPP
+#define LIBBITCOIN_SERVER_LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A high dynamic range histogram of latencies in microseconds.
+ *
+ * Values below 128 are counted exactly. Above that each power of two is
+ * split into 64 linear buckets, so any recorded value is within 1.6% of
+ * its bucket bounds, up to a maximum of about 71 minutes. Recording is a
+ * few relaxed atomic operations, and reads may run concurrently with it.
+ */
+class BCS_API latency_histogram
+{
+public:
+    latency_histogram();
+
+    latency_histogram(const latency_histogram&) = delete;
+    void operator=(const latency_histogram&) = delete;
+
+    void record(uint64_t microseconds);
+
+    uint64_t count() const;
+    uint64_t sum() const;
+    uint64_t maximum() const;
+
+    /// The upper bound of the bucket of the quantile (0 to 1), or zero.
+    uint64_t quantile(double fraction) const;
+
+private:
+    static constexpr size_t linear_buckets = 128;
+    static constexpr size_t half_buckets = linear_buckets / 2;
+    static constexpr uint64_t largest = 0xffffffff;
+    static constexpr size_t buckets = half_buckets * 25 + linear_buckets;
+
+    static size_t index(uint64_t value);
+    static uint64_t lower(size_t index);
+    static uint64_t upper(size_t index);
+
+    std::atomic<uint64_t> counts_[buckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> maximum_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -23,6 +23,7 @@
 #include <czmq++/czmqpp.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/server/define.hpp>
+#include <bitcoin/server/tracer.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -36,11 +37,19 @@ public:
     uint32_t id() const;
     const data_chunk& data() const;
 
+    /// The trace of a sampled request, shared by copies of the request.
+    void set_trace(request_trace::ptr trace);
+    const request_trace::ptr& trace() const;
+
+    /// Stamp the trace if the request is sampled.
+    void stamp(request_trace::point at) const;
+
 private:
     data_chunk origin_;
     std::string command_;
     uint32_t id_;
     data_chunk data_;
+    request_trace::ptr trace_;
 };
 
 // TODO: split into class per file.
@@ -54,11 +63,15 @@ public:
     outgoing_message(const incoming_message& request,
         const data_chunk& data);
 
+    /// Take the reply data without copying it.
+    outgoing_message(const incoming_message& request, data_chunk&& data);
+
     // Default constructor provided for containers and copying.
     outgoing_message();
 
     void send(czmqpp::socket& socket) const;
     uint32_t id() const;
+    const data_chunk& data() const;
 
 private:
     data_chunk dest_;
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_NEGATIVE_FILTERS_HPP
+#define LIBBITCOIN_SERVER_NEGATIVE_FILTERS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/bloom_filter.hpp>
+#include <bitcoin/server/callback_guard.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Bloom filters over every address, transaction hash and spent output of
+ * the chain and memory pool, used to answer lookups of unknown keys without
+ * reading the database.
+ *
+ * The filters are insert-only, so a key once seen is never reported absent,
+ * and a block reorganization leaves at most stale positives. They are
+ * populated by walking the chain in the background after startup, and
+ * report absence only once that walk is complete. Destruction stops the walk
+ * and waits for a block read in progress. This class is thread safe.
+ */
+class BCS_API negative_filters
+{
+public:
+    negative_filters(const settings& settings);
+    ~negative_filters();
+
+    /// Walk the chain to populate the filters, call once after start.
+    void load(blockchain::block_chain& chain);
+
+    /// Add a pooled or confirmed transaction.
+    void insert(const chain::transaction& tx, const hash_digest& hash);
+
+    /// False only if no transaction of the chain or pool has the address.
+    bool may_have_history(const short_hash& address_hash);
+
+    /// False only if no transaction of the chain or pool has the hash.
+    bool may_have_transaction(const hash_digest& tx_hash);
+
+    /// False only if no transaction of the chain or pool spends the output.
+    bool may_be_spent(const chain::output_point& outpoint);
+
+    bool enabled() const;
+    bool ready() const;
+    size_t negatives() const;
+    void log_status() const;
+
+private:
+    void handle_last_height(const code& ec, size_t last_height,
+        blockchain::block_chain& chain);
+    void load_block(size_t height, size_t last_height,
+        blockchain::block_chain& chain);
+    void handle_block(const code& ec, const chain::block& block,
+        size_t height, size_t last_height, blockchain::block_chain& chain);
+    bool found(const bloom_filter& filter, data_slice key);
+
+    bloom_filter addresses_;
+    bloom_filter transactions_;
+    bloom_filter spends_;
+    std::atomic<bool> ready_;
+    std::atomic<bool> stopped_;
+    std::atomic<size_t> negatives_;
+
+    // Keeps walk callbacks from running on a destroyed object.
+    callback_guard guard_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
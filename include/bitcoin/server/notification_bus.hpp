@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_NOTIFICATION_BUS_HPP
+#define LIBBITCOIN_SERVER_NOTIFICATION_BUS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A block connected to or disconnected from the chain, or a transaction
+ * accepted to the memory pool, with the analyses of its transactions.
+ */
+struct BCS_API notification
+{
+    typedef std::shared_ptr<const chain::block> block_ptr;
+    typedef std::shared_ptr<const chain::transaction> transaction_ptr;
+
+    enum class kind
+    {
+        block,
+        disconnect,
+        transaction
+    };
+
+    kind type;
+    uint32_t height;
+    block_ptr block;
+    transaction_ptr tx;
+    transaction_analysis::ptr analysis;
+    transaction_analysis::list analyses;
+};
+
+/**
+ * A disruptor style fan-out of node notifications to server consumers.
+ *
+ * The node publishes a pointer to each notification once into a ring which
+ * every consumer reads through its own cursor on its own thread, in batches
+ * and with its own wait strategy. The producer never waits for consumers,
+ * so a stalled consumer cannot hold up block and transaction validation:
+ * a consumer more than a full ring behind has been overrun, and skips the
+ * notifications overwritten under it. A consumer may also be subscribed to
+ * shed transactions while it is more than half a ring behind, so that it
+ * catches up before blocks are overwritten. Skipped notifications are
+ * counted against the consumer, which reports its lag. Consumers subscribed
+ * later see notifications published later.
+ */
+class BCS_API notification_bus
+{
+public:
+    typedef size_t consumer_id;
+    typedef std::function<void (const notification&)> handler;
+
+    enum class wait_strategy
+    {
+        /// Sleep until signaled by the producer.
+        blocking,
+
+        /// Yield the processor for a while before sleeping.
+        yielding
+    };
+
+    enum class overflow_policy
+    {
+        /// Skip only the notifications overwritten by the producer.
+        drop,
+
+        /// Also skip transaction notifications when half a ring behind.
+        shed_transactions
+    };
+
+    struct consumer_status
+    {
+        std::string name;
+        uint64_t lag;
+        uint64_t processed;
+        uint64_t batches;
+        uint64_t dropped;
+    };
+
+    typedef std::vector<consumer_status> status_list;
+
+    notification_bus(size_t capacity);
+    ~notification_bus();
+
+    notification_bus(const notification_bus&) = delete;
+    void operator=(const notification_bus&) = delete;
+
+    /// Start a consumer thread, the handler is called on it in order.
+    consumer_id subscribe(const std::string& name, handler handle,
+        wait_strategy strategy, overflow_policy overflow, size_t batch_size);
+
+    /// Stop and join a consumer, do not call from its own handler.
+    void unsubscribe(consumer_id id);
+
+    /// Stop and join all consumers.
+    void stop();
+
+    /// Thread safe, never waits for consumers.
+    void publish(notification&& item);
+
+    /// True if there is at least one consumer.
+    bool subscribed() const;
+
+    status_list status() const;
+
+    /// The notifications skipped by all consumers.
+    uint64_t dropped() const;
+
+private:
+    // Keep consumer cursors off the cache line of the ring cursor.
+    static constexpr size_t cache_line = 64;
+
+    // A published notification, which a consumer holds while handling it
+    // so that the producer may overwrite its slot.
+    struct entry
+    {
+        uint64_t sequence;
+        notification item;
+    };
+
+    typedef std::shared_ptr<const entry> entry_ptr;
+
+    struct consumer
+    {
+        consumer(const std::string& name, handler handle,
+            wait_strategy strategy, overflow_policy overflow,
+            size_t batch_size, uint64_t start);
+
+        const std::string name;
+        const handler handle;
+        const wait_strategy strategy;
+        const overflow_policy overflow;
+        const size_t batch_size;
+        char pad0[cache_line];
+        std::atomic<uint64_t> cursor;
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> batches;
+        std::atomic<uint64_t> dropped;
+        std::atomic<bool> stopped;
+        char pad1[cache_line];
+        std::thread thread;
+    };
+
+    typedef std::shared_ptr<consumer> consumer_ptr;
+    typedef std::map<consumer_id, consumer_ptr> consumer_map;
+
+    void run(consumer_ptr reader);
+    void wait(consumer& reader, uint64_t cursor, size_t& spins);
+    void signal();
+    bool shed(const consumer& reader, const notification& item,
+        uint64_t sequence, uint64_t available) const;
+    void join(consumer_ptr reader);
+    uint64_t gate(uint64_t next) const;
+
+    const uint64_t mask_;
+    const std::unique_ptr<entry_ptr[]> ring_;
+    char pad0_[cache_line];
+    std::atomic<uint64_t> published_;
+    char pad1_[cache_line];
+
+    // Serializes producers (the node calls from several threads) and
+    // changes to the consumer set, which bounds the slots released.
+    mutable std::mutex producer_mutex_;
+    consumer_map consumers_;
+    consumer_id next_id_;
+    uint64_t released_;
+    std::atomic<size_t> consumer_count_;
+
+    // Wakeup of blocking consumers.
+    std::mutex wait_mutex_;
+    std::condition_variable wakeup_;
+    std::atomic<size_t> sleepers_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -20,34 +20,134 @@
 #ifndef LIBBITCOIN_SERVER_PUBLISHER_HPP
 #define LIBBITCOIN_SERVER_PUBLISHER_HPP
 
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <czmq++/czmqpp.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/server/config/settings.hpp>
 #include <bitcoin/server/define.hpp>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/notification_bus.hpp>
+#include <bitcoin/server/replay_buffer.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
+#include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
 namespace server {
 
+/**
+ * Publishes blocks and transactions on their own thread.
+ *
+ * The publisher is a consumer of the node notification bus, so serialization
+ * and socket writes never run on node threads and the sockets are only ever
+ * used by the bus consumer thread.
+ *
+ * When sequencing is enabled each feed numbers its messages and retains the
+ * most recent ones for replay through the query service.
+ *
+ * Blocks replaced by a reorganization may be announced on the block feed,
+ * tip first, before the blocks which replace them.
+ *
+ * In compact block mode (BIP152 style) blocks are published with 6 byte
+ * short ids in place of the transactions already sent on the tx feed.
+ *
+ * Optionally each block is also published in full on its own endpoint, for
+ * consumers which would otherwise fetch every transaction of every block.
+ *
+ * The sockets are XPUB, so the publisher tracks the topics subscribed on
+ * each feed and does no work for messages that no subscriber would receive.
+ */
 class BCS_API publisher
 {
 public:
+    typedef std::set<data_chunk> topic_set;
+
+    /// Feed identifiers for replay requests.
+    static constexpr uint8_t block_feed = 0;
+    static constexpr uint8_t transaction_feed = 1;
+    static constexpr uint8_t raw_block_feed = 2;
+
     publisher(server_node& node, const settings& settings);
+    ~publisher();
 
     bool start();
     bool stop();
 
+    /// Query handler for server.replay.
+    void replay(const incoming_message& request,
+        queue_send_callback queue_send);
+
+    /// Query handler for server.fetch_compact_transactions.
+    void fetch_compact_transactions(const incoming_message& request,
+        queue_send_callback queue_send);
+
 private:
-    void send_tx(const chain::transaction& tx);
-    void send_block(uint32_t height, const chain::block& block);
+    struct feed
+    {
+        feed(size_t replay_capacity);
+
+        // Only used by the publisher thread.
+        uint64_t sequence;
+        replay_buffer replay;
+        topic_set subscriptions;
+    };
+
+    struct compact_block
+    {
+        hash_digest hash;
+        transaction_analysis::list analyses;
+        std::unordered_map<uint64_t, size_t> indexes;
+    };
+
+    void receive(const notification& item);
+    void send_tx(const chain::transaction& tx,
+        transaction_analysis::ptr analysis);
+    void send_block(uint32_t height, const chain::block& block,
+        const transaction_analysis::list& analyses);
+    void send_raw_block(uint32_t height, const chain::block& block,
+        const transaction_analysis::list& analyses);
+    void send_disconnect(uint32_t height, const chain::block& block,
+        const transaction_analysis::list& analyses);
+    void send_compact_block(uint32_t height, const chain::block& block,
+        const transaction_analysis::list& analyses);
+    void set_published(const hash_digest& tx_hash);
+    bool publish(czmqpp::socket& socket, feed& target,
+        const data_stack& payload, const topic_set& topics);
+    data_chunk record(feed& target, const data_stack& payload);
+    bool send(czmqpp::socket& socket, const data_chunk& raw_sequence,
+        const data_stack& payload, const topic_set& topics);
+    bool idle(czmqpp::socket& socket, feed& target);
+    void update_subscriptions(czmqpp::socket& socket, feed& target);
+    topic_set subscribed(const feed& target, const topic_set& topics) const;
     bool setup_socket(const std::string& connection, czmqpp::socket& socket);
 
     server_node& node_;
     czmqpp::context context_;
     czmqpp::socket socket_block_;
     czmqpp::socket socket_tx_;
+    czmqpp::socket socket_raw_block_;
+    feed block_feed_;
+    feed tx_feed_;
+    feed raw_block_feed_;
     const settings& settings_;
+
+    // The bus consumer which runs the publisher.
+    notification_bus::consumer_id consumer_;
+    bool started_;
+
+    // Unconfirmed transactions sent on the tx feed (publisher thread).
+    std::unordered_set<hash_digest> published_;
+    std::deque<hash_digest> published_order_;
+
+    // Recent compact blocks, for recovery of missing transactions.
+    std::deque<compact_block> compact_blocks_;
+    std::mutex compact_mutex_;
 };
 
 } // namespace server
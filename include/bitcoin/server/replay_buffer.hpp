@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_REPLAY_BUFFER_HPP
+#define LIBBITCOIN_SERVER_REPLAY_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * The most recent messages of a publisher feed, by sequence number.
+ *
+ * Subscribers that detect a gap in sequence numbers replay the missed range
+ * from here instead of resynchronizing through the query service.
+ * This class is thread safe.
+ */
+class BCS_API replay_buffer
+{
+public:
+    struct entry
+    {
+        uint64_t sequence;
+        data_stack frames;
+    };
+
+    typedef std::vector<entry> list;
+
+    replay_buffer(size_t capacity);
+
+    /// Store a message, sequences must be stored in increasing order.
+    void store(uint64_t sequence, const data_stack& frames);
+
+    /// Get up to count messages starting at the sequence (or the oldest).
+    list fetch(uint64_t from_sequence, size_t count) const;
+
+private:
+    const size_t capacity_;
+    std::deque<entry> entries_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_REPLY_TRACKER_HPP
+#define LIBBITCOIN_SERVER_REPLY_TRACKER_HPP
+
+#include <atomic>
+#include <memory>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/service/util.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Tracks the reply callback handed to a query handler, so the caller can
+ * tell once the handler returns whether it dropped the query: it neither
+ * replied nor kept the callback to reply later, as handlers do with
+ * invalid requests. Such a query never replies, so must not hold the
+ * concurrency of its class until it expires.
+ *
+ * The wrapped callback may be called and released on any thread.
+ */
+class BCS_API reply_tracker
+{
+public:
+    reply_tracker();
+
+    reply_tracker(const reply_tracker&) = delete;
+    void operator=(const reply_tracker&) = delete;
+
+    /// The reply, which marks the query as replied when called.
+    queue_send_callback wrap(queue_send_callback reply) const;
+
+    /// True if no reply was sent and no wrapped callback remains.
+    bool abandoned() const;
+
+private:
+    // Shared by the wrapped callbacks, so also counts them.
+    const std::shared_ptr<std::atomic<bool>> replied_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_REQUEST_LOG_HPP
+#define LIBBITCOIN_SERVER_REQUEST_LOG_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/message.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A request read from a request log, timed from the start of recording.
+ */
+struct BCS_API recorded_request
+{
+    uint64_t microseconds;
+    std::string command;
+    data_chunk data;
+};
+
+/**
+ * Writes received requests to a compact binary log for later replay.
+ *
+ * The log is the magic "BSRL", a version byte, then for each request its
+ * microseconds since the previous request, command and data, each length
+ * or value a Bitcoin variable length integer. Client identities and request
+ * ids are not recorded. This class is not thread safe, it is owned by the
+ * worker thread.
+ */
+class BCS_API request_recorder
+{
+public:
+    request_recorder(const boost::filesystem::path& file);
+    ~request_recorder();
+
+    bool start();
+    void stop();
+    void record(const incoming_message& request);
+    void flush();
+
+    uint64_t recorded() const;
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    const boost::filesystem::path path_;
+    std::ofstream file_;
+    clock::time_point previous_;
+    uint64_t recorded_;
+};
+
+/**
+ * Reads a request log written by request_recorder.
+ */
+class BCS_API request_log_reader
+{
+public:
+    request_log_reader(const boost::filesystem::path& file);
+
+    /// False if the file could not be opened or is not a request log.
+    bool valid() const;
+
+    /// Read the next request, false at the end of the log.
+    bool read(recorded_request& out);
+
+private:
+    std::ifstream file_;
+    uint64_t elapsed_;
+    bool valid_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_REQUEST_LOGGER_HPP
+#define LIBBITCOIN_SERVER_REQUEST_LOGGER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/ring_buffer.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Asynchronous logging of query requests and their replies.
+ *
+ * Each event is copied into a fixed-size binary record, its format and
+ * arguments, and pushed to a lock-free ring buffer. A background thread
+ * formats the records and writes them to the request log, so no string is
+ * formatted and no log lock is taken on the query path. Records are
+ * dropped, and counted, rather than block when the buffer is full.
+ *
+ * One in the sample interval of requests is logged, chosen by request id,
+ * so that each logged request has all its events. Command names must
+ * outlive the logger. Logging is safe from any thread once started.
+ */
+class BCS_API request_logger
+{
+public:
+    enum class event : uint8_t
+    {
+        receive,
+        reply,
+        shed
+    };
+
+    request_logger(const settings& settings);
+    ~request_logger();
+
+    bool start();
+    void stop();
+
+    /// True if the events of the request are logged.
+    bool sampled(const incoming_message& request) const;
+
+    /// Log the receipt or shedding of a sampled request.
+    void log(event type, const std::string& command,
+        const incoming_message& request);
+
+    /// Log a reply to a sampled request.
+    void log(const std::string& command, const data_chunk& origin,
+        const outgoing_message& reply);
+
+    uint64_t dropped() const;
+
+private:
+    typedef std::chrono::system_clock clock;
+
+    // The origin and data are truncated to their arrays, with their full
+    // sizes recorded. A reply records its error code as the value.
+    struct record
+    {
+        event type;
+        uint8_t origin_size;
+        uint32_t id;
+        uint32_t value;
+        uint32_t data_size;
+        clock::time_point time;
+        const std::string* command;
+        std::array<uint8_t, 16> origin;
+        std::array<uint8_t, 40> data;
+    };
+
+    void push(record& item);
+    void run();
+    void write(const record& item) const;
+
+    const uint32_t sample_interval_;
+    ring_buffer<record> buffer_;
+    std::atomic<bool> started_;
+    std::atomic<bool> stopped_;
+    std::atomic<uint64_t> dropped_;
+    std::thread thread_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
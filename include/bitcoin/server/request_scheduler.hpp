@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_REQUEST_SCHEDULER_HPP
+#define LIBBITCOIN_SERVER_REQUEST_SCHEDULER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/// The cost class of a query command.
+enum class request_class
+{
+    /// Constant time reads, never deferred or shed.
+    cheap = 0,
+
+    /// Single reads and pool operations.
+    normal,
+
+    /// Scans and batches whose cost grows with the request.
+    expensive
+};
+
+/**
+ * Admission control of queries by cost class and by client, so that cheap
+ * queries are not delayed behind history and stealth scans, and one client
+ * cannot monopolize the handlers.
+ *
+ * Cheap queries run as they arrive. Normal and expensive queries run up to
+ * the configured concurrency of their class, and beyond it are deferred in
+ * a queue per client (ROUTER identity). Deferred queries of a class run in
+ * deficit round robin order of their clients, each client taking up to its
+ * weight of queries per round.
+ *
+ * Each client queue is managed by the CoDel controlled delay algorithm: once
+ * its queueing delay has stayed above the target for an interval, queries
+ * are shed from the head of the queue at an increasing rate until the delay
+ * falls below the target. Clients may also be limited to a rate of queries
+ * by a token bucket, scaled by their weight, with those over the limit shed
+ * as they arrive.
+ *
+ * This class is not thread safe, it is owned by the request_worker thread.
+ */
+class BCS_API request_scheduler
+{
+public:
+    typedef std::chrono::steady_clock clock;
+    typedef std::function<clock::time_point ()> time_source;
+    typedef std::function<void ()> action;
+
+    static constexpr size_t classes = 3;
+
+    /// The time is the steady clock unless replaced, for tests.
+    request_scheduler(const settings& settings,
+        time_source now=&clock::now);
+
+    /// The cost class of a command, normal if the command is unknown.
+    static request_class classify(const std::string& command);
+
+    /// The name of a class, for statistics.
+    static std::string to_string(request_class type);
+
+    /// Run the query now if its class is below its concurrency, otherwise
+    /// defer it. A deferred query is later either run or shed. A query over
+    /// the rate limit of its client is shed now.
+    void submit(request_class type, const data_chunk& origin, action run,
+        action shed);
+
+    /// Release the concurrency of a completed query of the class, deferred
+    /// queries run on the next update.
+    void release(request_class type);
+
+    /// Run deferred queries within concurrency and shed those delayed too
+    /// long, call on each poll of the worker.
+    void update();
+
+    uint64_t running(request_class type) const;
+    uint64_t deferred(request_class type) const;
+    uint64_t shed(request_class type) const;
+    uint64_t limited() const;
+
+private:
+    struct entry
+    {
+        clock::time_point enqueued;
+        action run;
+        action shed;
+    };
+
+    // The deferred queries of one client in one class.
+    struct flow
+    {
+        std::deque<entry> queue;
+        uint32_t weight = 1;
+        uint32_t deficit = 0;
+
+        // CoDel state, zero time if the delay is below target.
+        clock::time_point first_above;
+        clock::time_point drop_next;
+        uint32_t count = 0;
+        bool dropping = false;
+    };
+
+    struct lane
+    {
+        size_t limit = 0;
+        size_t running = 0;
+        size_t deferred = 0;
+        uint64_t shed = 0;
+        std::map<data_chunk, flow> flows;
+
+        // The round robin order of clients with deferred queries.
+        std::deque<data_chunk> active;
+    };
+
+    struct bucket
+    {
+        double tokens;
+        clock::time_point updated;
+    };
+
+    typedef std::map<data_chunk, uint32_t> weight_map;
+    typedef std::map<data_chunk, bucket> bucket_map;
+
+    static weight_map parse_weights(
+        const std::vector<std::string>& weights);
+
+    uint32_t weight(const data_chunk& origin) const;
+    bool take_token(const data_chunk& origin, clock::time_point now);
+    void prune_buckets(clock::time_point now);
+    bool should_shed(flow& client, clock::time_point now,
+        clock::duration delay);
+    clock::time_point control_law(clock::time_point time,
+        uint32_t count) const;
+    void shed_delayed(lane& queue, clock::time_point now);
+    void drain(lane& queue, clock::time_point now);
+
+    const time_source now_;
+    const clock::duration target_;
+    const clock::duration interval_;
+    const double rate_;
+    const double burst_;
+    const weight_map weights_;
+    std::array<lane, classes> lanes_;
+    bucket_map buckets_;
+    clock::time_point next_prune_;
+    uint64_t limited_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_RING_BUFFER_HPP
+#define LIBBITCOIN_SERVER_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A bounded lock-free multiple producer queue of fixed capacity.
+ *
+ * Each cell carries a sequence number which tells producers and consumers
+ * whether it is free or published, so that neither side takes a lock. The
+ * capacity is rounded up to a power of two. Push fails rather than blocks
+ * when the buffer is full and pop fails when it is empty.
+ */
+template <typename Item>
+class ring_buffer
+{
+public:
+    ring_buffer(size_t capacity)
+      : mask_(round_up(capacity) - 1),
+        cells_(new cell[mask_ + 1]),
+        enqueue_(0),
+        dequeue_(0)
+    {
+        for (size_t index = 0; index <= mask_; ++index)
+            cells_[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    ring_buffer(const ring_buffer&) = delete;
+    void operator=(const ring_buffer&) = delete;
+
+    /// Safe to call from any thread, returns false if full.
+    bool push(Item&& item)
+    {
+        auto position = enqueue_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& slot = cells_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position);
+
+            if (difference == 0)
+            {
+                // The cell is free, claim it.
+                if (enqueue_.compare_exchange_weak(position, position + 1,
+                    std::memory_order_relaxed))
+                {
+                    slot.item = std::move(item);
+                    slot.sequence.store(position + 1,
+                        std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The cell has not been consumed since the last lap.
+                return false;
+            }
+            else
+            {
+                // Another producer claimed the cell.
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Safe to call from any thread, returns false if empty.
+    bool pop(Item& out)
+    {
+        auto position = dequeue_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& slot = cells_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position + 1);
+
+            if (difference == 0)
+            {
+                // The cell is published, claim it.
+                if (dequeue_.compare_exchange_weak(position, position + 1,
+                    std::memory_order_relaxed))
+                {
+                    out = std::move(slot.item);
+                    slot.item = Item();
+                    slot.sequence.store(position + mask_ + 1,
+                        std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The cell has not been published.
+                return false;
+            }
+            else
+            {
+                // Another consumer claimed the cell.
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// An approximation when other threads are active.
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /// An approximation when other threads are active.
+    size_t size() const
+    {
+        const auto head = dequeue_.load(std::memory_order_acquire);
+        const auto tail = enqueue_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    // Keep the producer and consumer counters on separate cache lines.
+    static constexpr size_t cache_line = 64;
+
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        Item item;
+    };
+
+    static size_t round_up(size_t value)
+    {
+        size_t power = 2;
+        while (power < value)
+            power <<= 1;
+
+        return power;
+    }
+
+    const size_t mask_;
+    const std::unique_ptr<cell[]> cells_;
+    char pad0_[cache_line];
+    std::atomic<size_t> enqueue_;
+    char pad1_[cache_line];
+    std::atomic<size_t> dequeue_;
+    char pad2_[cache_line];
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
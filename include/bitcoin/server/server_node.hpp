@@ -21,11 +21,18 @@
 #define LIBBITCOIN_SERVER_SERVER_NODE_HPP
 
 #include <cstdint>
+#include <memory>
 #include <bitcoin/node.hpp>
 #include <bitcoin/server/config/configuration.hpp>
 #include <bitcoin/server/config/settings.hpp>
 #include <bitcoin/server/define.hpp>
+#include <bitcoin/server/header_store.hpp>
+#include <bitcoin/server/hot_address_cache.hpp>
 #include <bitcoin/server/message.hpp>
+#include <bitcoin/server/negative_filters.hpp>
+#include <bitcoin/server/notification_bus.hpp>
+#include <bitcoin/server/statistics.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
 #include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
@@ -35,17 +42,24 @@ class BCS_API server_node
   : public node::full_node
 {
 public:
-    typedef std::function<void (size_t, const chain::block&)>
-        block_notify_callback;
-    typedef std::function<void (const chain::transaction&)>
-        transaction_notify_callback;
-
     static const configuration defaults;
 
     server_node(const configuration& config=defaults);
 
-    virtual void subscribe_blocks(block_notify_callback notify_block);
-    virtual void subscribe_transactions(transaction_notify_callback notify_tx);
+    /// Block, disconnect and transaction notifications for server services.
+    virtual notification_bus& notifications();
+
+    /// Cached histories of the most queried addresses.
+    virtual hot_address_cache& hot_addresses();
+
+    /// Filters of the keys known to the chain and memory pool.
+    virtual negative_filters& filters();
+
+    /// The block headers of the chain, for header range queries.
+    virtual header_store& headers();
+
+    /// Request and server statistics.
+    virtual statistics& stats();
 
     static void fullnode_fetch_history(server_node& node,
         const incoming_message& request, queue_send_callback queue_send);
@@ -60,12 +74,27 @@ protected:
         const blockchain::block_chain::list& replaced_blocks) override;
 
 private:
-    typedef std::vector<block_notify_callback> block_notify_list;
-    typedef std::vector<transaction_notify_callback> transaction_notify_list;
+    transaction_analysis::list analyze(const chain::block& block);
+    void log_notification_status();
+    void add_gauges();
+
+    // Shared analysis of transactions for all notification subscribers.
+    transaction_cache tx_cache_;
+
+    // Fan-out of notifications to the server services.
+    notification_bus notifications_;
+
+    // Histories of the most queried addresses.
+    hot_address_cache hot_addresses_;
+
+    // Lookups of unknown keys answered without the database.
+    negative_filters filters_;
+
+    // Serialized headers of the chain for header range queries.
+    header_store headers_;
 
-    // Subscriptions for server API.
-    block_notify_list block_sunscriptions_;
-    transaction_notify_list tx_subscriptions_;
+    // Counters, latencies and gauges for the stats query and endpoint.
+    statistics stats_;
 
     size_t last_checkpoint_height_;
     asio::timer retry_start_timer_;
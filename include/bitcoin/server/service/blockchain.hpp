@@ -20,6 +20,7 @@
 #ifndef LIBBITCOIN_SERVER_BLOCKCHAIN_HPP
 #define LIBBITCOIN_SERVER_BLOCKCHAIN_HPP
 
+#include <bitcoin/node.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/service/util.hpp>
 
@@ -34,14 +35,23 @@ void BCS_API blockchain_fetch_history(server_node& node,
 void BCS_API blockchain_fetch_transaction(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
 
+void BCS_API blockchain_fetch_transactions(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
+
+void BCS_API blockchain_fetch_transaction_with_prevouts(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
+
 void BCS_API blockchain_fetch_last_height(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
 
 void BCS_API blockchain_fetch_block_header(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
 
-////void BCS_API blockchain_fetch_block_transaction_hashes(server_node& node,
-////    const incoming_message& request, queue_send_callback queue_send);
+void BCS_API blockchain_fetch_block_headers(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
+
+void BCS_API blockchain_fetch_block_transaction_hashes(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
 
 void BCS_API blockchain_fetch_transaction_index(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
@@ -55,6 +65,10 @@ void BCS_API blockchain_fetch_block_height(server_node& node,
 void BCS_API blockchain_fetch_stealth(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
 
+void BCS_API stealth_fetched(const code& ec,
+    const blockchain::block_chain::stealth& stealth_results,
+    const incoming_message& request, queue_send_callback queue_send);
+
 } // namespace server
 } // namespace libbitcoin
 
@@ -32,6 +32,11 @@ class server_node;
 void BCS_API COMPAT_fetch_history(server_node& node,
     const incoming_message& request, queue_send_callback queue_send);
 
+void BCS_API COMPAT_send_history_result(const code& ec,
+    const blockchain::block_chain::history& history,
+    const incoming_message& request, queue_send_callback queue_send,
+    const uint64_t from_height);
+
 } // namespace server
 } // namespace libbitcoin
 
@@ -20,7 +20,9 @@
 #ifndef LIBBITCOIN_SERVER_FETCH_X_HPP
 #define LIBBITCOIN_SERVER_FETCH_X_HPP
 
+#include <functional>
 #include <bitcoin/server/define.hpp>
+#include <bitcoin/server/hot_address_cache.hpp>
 #include <bitcoin/server/server_node.hpp>
 #include <bitcoin/server/service/util.hpp>
 
@@ -33,10 +35,20 @@ bool BCS_API unwrap_fetch_history_args(
     bc::wallet::payment_address& address, uint32_t& from_height,
     const incoming_message& request);
 
+typedef std::function<void (const code&,
+    const blockchain::block_chain::history&)> history_handler;
+
+data_chunk BCS_API history_result(const code& ec,
+    const blockchain::block_chain::history& history);
+
 void BCS_API send_history_result(const code& ec,
     const blockchain::block_chain::history& history,
     const incoming_message& request, queue_send_callback queue_send);
 
+history_handler BCS_API cache_history_result(hot_address_cache& cache,
+    const short_hash& hash, hot_address_cache::source from,
+    uint64_t generation, history_handler handler);
+
 // fetch_transaction stuff
 
 bool BCS_API unwrap_fetch_transaction_args(bc::hash_digest& tx_hash,
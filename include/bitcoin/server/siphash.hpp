@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_SIPHASH_HPP
+#define LIBBITCOIN_SERVER_SIPHASH_HPP
+
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+struct BCS_API siphash_key
+{
+    uint64_t k0;
+    uint64_t k1;
+};
+
+/**
+ * SipHash-2-4 of the message, as used for BIP152 short transaction ids.
+ */
+BCS_API uint64_t siphash(const siphash_key& key, data_slice message);
+
+/**
+ * The BIP152 short id key of a block, the first 16 bytes of the sha256 of
+ * its serialized header followed by the little endian nonce.
+ */
+BCS_API siphash_key short_id_key(data_slice raw_header, uint64_t nonce);
+
+/**
+ * The BIP152 short id of a transaction, the low 6 bytes of its siphash.
+ */
+BCS_API uint64_t short_id(const siphash_key& key, const hash_digest& tx_hash);
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_STATISTICS_HPP
+#define LIBBITCOIN_SERVER_STATISTICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/latency_histogram.hpp>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/service/util.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * Per-command request counters and stage latencies, and server gauges,
+ * rendered in the Prometheus text exposition format.
+ *
+ * Each request is timed in three stages: queue (receipt to dispatch),
+ * handler (dispatch to reply, including the database read and the
+ * serialization of the reply) and send (reply to its write on the query
+ * socket). Commands and gauges are added before the worker starts, after
+ * which recording is lock-free from any thread. Gauges are read on the
+ * worker thread.
+ */
+class BCS_API statistics
+{
+public:
+    typedef std::chrono::steady_clock clock;
+    typedef std::function<uint64_t()> gauge;
+
+    struct command
+    {
+        latency_histogram queue;
+        latency_histogram handler;
+        latency_histogram send;
+        std::atomic<uint64_t> requests{ 0 };
+        std::atomic<uint64_t> replies{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> notifications{ 0 };
+        std::atomic<uint64_t> bytes_in{ 0 };
+        std::atomic<uint64_t> bytes_out{ 0 };
+    };
+
+    /// The timing of one request, shared by the worker and its reply.
+    struct request
+    {
+        typedef std::shared_ptr<request> ptr;
+
+        request(command& stats, clock::time_point received);
+
+        command& stats;
+        const clock::time_point received;
+        clock::time_point dispatched;
+
+        // Ticks of the first reply, zero until replied.
+        std::atomic<clock::rep> replied;
+    };
+
+    statistics();
+
+    /// Add a command, call before the worker starts.
+    command& add(const std::string& name);
+
+    /// Add a named gauge, call before the worker starts.
+    void add_gauge(const std::string& name, gauge value);
+
+    /// Start timing a received request.
+    request::ptr receive(command& stats, size_t bytes);
+
+    /// Stamp the dispatch of the request to its handler.
+    void dispatch(request& timing);
+
+    /// Count a reply, any after the first are subscription notifications.
+    void reply(request& timing, const outgoing_message& message);
+
+    /// Stamp the write of the reply on the query socket.
+    void sent(request& timing);
+
+    /// Count a request with no handler, or with no reply.
+    void unhandled();
+    void unanswered();
+
+    /// The statistics as text, call on the worker thread.
+    std::string to_text() const;
+
+    /// Reply with the statistics as text.
+    void fetch(const incoming_message& request,
+        queue_send_callback queue_send);
+
+private:
+    typedef std::map<std::string, std::unique_ptr<command>> command_map;
+    typedef std::map<std::string, gauge> gauge_map;
+
+    command_map commands_;
+    gauge_map gauges_;
+    std::atomic<uint64_t> unhandled_;
+    std::atomic<uint64_t> unanswered_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
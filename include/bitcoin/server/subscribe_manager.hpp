@@ -20,14 +20,20 @@
 #ifndef LIBBITCOIN_SERVER_SUBSCRIBE_MANAGER_HPP
 #define LIBBITCOIN_SERVER_SUBSCRIBE_MANAGER_HPP
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/server/config/settings.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/message.hpp>
+#include <bitcoin/server/notification_bus.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
 #include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
@@ -44,13 +50,25 @@ class BCS_API subscribe_manager
 public:
 
     subscribe_manager(server_node& node, const settings& settings);
+    ~subscribe_manager();
 
     void subscribe(const incoming_message& request,
         queue_send_callback queue_send);
     void renew(const incoming_message& request,
         queue_send_callback queue_send);
     void submit(size_t height, const hash_digest& block_hash,
-        const chain::transaction& tx);
+        transaction_analysis::ptr tx);
+    void disconnect(size_t height, const hash_digest& block_hash,
+        transaction_analysis::ptr tx);
+    void unsubscribe(const data_chunk& client_origin);
+
+protected:
+    // The work of subscribe and submit, run on the dispatcher or on the
+    // notification consumer thread.
+    void do_subscribe(const incoming_message& request,
+        queue_send_callback queue_send);
+    void do_submit(size_t height, const hash_digest& block_hash,
+        transaction_analysis::ptr tx);
 
 private:
     struct subscription
@@ -64,23 +82,33 @@ private:
 
     typedef std::vector<subscription> subscription_list;
 
+    void receive(const notification& item);
     code add_subscription(const incoming_message& request,
         queue_send_callback queue_send);
-    void do_subscribe(const incoming_message& request,
-        queue_send_callback queue_send);
     void do_renew(const incoming_message& request,
         queue_send_callback queue_send);
-    void do_submit(size_t height, const hash_digest& block_hash,
-        const chain::transaction& tx);
+    void do_disconnect(size_t height, const hash_digest& block_hash,
+        transaction_analysis::ptr tx);
+    void do_unsubscribe(const data_chunk& client_origin);
     void post_updates(const wallet::payment_address& address,
-        size_t height, const hash_digest& block_hash,
-        const chain::transaction& tx);
+        size_t height, const hash_digest& block_hash, const data_chunk& tx,
+        const std::string& command);
     void post_stealth_updates(uint32_t prefix, size_t height,
-        const hash_digest& block_hash, const chain::transaction& tx);
+        const hash_digest& block_hash, const data_chunk& tx,
+        const std::string& command);
     void sweep_expired();
 
+    server_node& node_;
+    notification_bus::consumer_id consumer_;
     dispatcher dispatch_;
+
+    // Guards the subscriptions, which requests change on the dispatcher
+    // while notifications are sent on the consumer thread.
+    std::mutex mutex_;
     subscription_list subscriptions_;
+
+    // The subscription count, readable from outside the dispatcher.
+    std::atomic<size_t> size_;
     const settings& settings_;
 };
 
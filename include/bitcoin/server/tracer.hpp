@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_TRACER_HPP
+#define LIBBITCOIN_SERVER_TRACER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * The monotonic timestamps of one sampled request, from its receipt to the
+ * write of its reply. Each point may be stamped from any thread, and only
+ * the first stamp of a point is kept.
+ */
+class BCS_API request_trace
+{
+public:
+    typedef std::shared_ptr<request_trace> ptr;
+    typedef std::chrono::steady_clock clock;
+
+    enum class point
+    {
+        /// Read from the query socket.
+        receive = 0,
+
+        /// Passed to the command handler.
+        dispatch,
+
+        /// The blockchain or pool callback invoked.
+        database,
+
+        /// The reply serialized and queued to the send worker.
+        reply,
+
+        /// The reply taken from the send queue by the worker.
+        dequeue,
+
+        /// The reply written to the query socket.
+        send
+    };
+
+    static constexpr size_t points = 6;
+
+    request_trace(uint64_t id, const std::string& command,
+        uint32_t request_id);
+
+    void stamp(point at);
+
+    /// Microseconds of the monotonic clock, or zero if not stamped.
+    uint64_t time(point at) const;
+
+    uint64_t id() const;
+    const std::string& command() const;
+    uint32_t request_id() const;
+
+private:
+    const uint64_t id_;
+    const std::string command_;
+    const uint32_t request_id_;
+    std::array<std::atomic<uint64_t>, points> times_;
+};
+
+/**
+ * Samples one in every trace_sample_interval requests for tracing, and
+ * writes their traces to the trace file in the Chrome trace event format
+ * (viewable in chrome://tracing or Perfetto). Each request is a row, with
+ * an event for the whole request and one for each stage between stamps.
+ *
+ * The file is a JSON array left open for appending, which the format
+ * permits. This class is not thread safe, it is owned by the worker thread.
+ */
+class BCS_API tracer
+{
+public:
+    tracer(const settings& settings);
+    ~tracer();
+
+    bool start();
+    void stop();
+
+    /// A new trace if this request is sampled, otherwise nullptr.
+    request_trace::ptr sample(const std::string& command,
+        uint32_t request_id);
+
+    /// Write a completed (or abandoned) trace.
+    void write(const request_trace& trace);
+
+    void flush();
+
+private:
+    void write_event(const request_trace& trace, const std::string& name,
+        uint64_t start, uint64_t end);
+
+    const uint32_t interval_;
+    const settings& settings_;
+    uint64_t requests_;
+    uint64_t traces_;
+    bool first_event_;
+    std::ofstream file_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
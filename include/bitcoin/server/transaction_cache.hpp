@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_TRANSACTION_CACHE_HPP
+#define LIBBITCOIN_SERVER_TRANSACTION_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * The result of analyzing a transaction for the server notification
+ * pipelines: its hash, its serialization and the addresses and stealth
+ * prefixes extracted from its scripts.
+ */
+struct BCS_API transaction_analysis
+{
+    typedef std::shared_ptr<const transaction_analysis> ptr;
+    typedef std::vector<ptr> list;
+
+    hash_digest hash;
+    data_chunk data;
+    std::vector<wallet::payment_address> input_addresses;
+    std::vector<wallet::payment_address> output_addresses;
+    std::vector<uint32_t> stealth_prefixes;
+};
+
+/**
+ * A bounded LRU cache of transaction analyses keyed by transaction hash.
+ *
+ * Transactions are analyzed once on first sighting (normally on entry to the
+ * memory pool) so that confirmation in a block, and each subscriber of
+ * either notification, reuses the same result. This class is thread safe.
+ */
+class BCS_API transaction_cache
+{
+public:
+    transaction_cache(size_t capacity);
+
+    /// Get the analysis of a transaction of known hash.
+    transaction_analysis::ptr get(const chain::transaction& tx,
+        const hash_digest& hash);
+
+    /// Get the analysis of a transaction, computing its hash from a
+    /// serialization into the buffer, which callers reuse across calls.
+    transaction_analysis::ptr get(const chain::transaction& tx,
+        data_chunk& buffer);
+
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    typedef std::list<transaction_analysis::ptr> lru_list;
+    typedef std::unordered_map<hash_digest, lru_list::iterator> lru_index;
+
+    transaction_analysis::ptr find(const hash_digest& hash);
+    transaction_analysis::ptr store(transaction_analysis::ptr analysis);
+
+    const size_t capacity_;
+    lru_list entries_;
+    lru_index index_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
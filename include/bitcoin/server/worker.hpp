@@ -22,16 +22,24 @@
 
 #include <condition_variable>
 #include <cstdint>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <boost/date_time.hpp>
 #include <czmq++/czmqpp.hpp>
 #include <bitcoin/node.hpp>
+#include <bitcoin/server/client_queue.hpp>
 #include <bitcoin/server/config/settings.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/message.hpp>
+#include <bitcoin/server/request_log.hpp>
+#include <bitcoin/server/request_logger.hpp>
+#include <bitcoin/server/request_scheduler.hpp>
+#include <bitcoin/server/statistics.hpp>
+#include <bitcoin/server/tracer.hpp>
 #include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
@@ -64,30 +72,86 @@ public:
     typedef std::function<void(const incoming_message&, queue_send_callback)>
         command_handler;
 
-    request_worker(const settings& settings);
+    request_worker(statistics& stats, const settings& settings);
 
     bool start();
     bool stop();
     void update();
     void attach(const std::string& command, command_handler handler);
 
+    /// Invoked on the worker thread when a slow client is disconnected.
+    void set_disconnect_handler(client_queue::disconnect_handler handler);
+
+    /// The outbound queue depth of each client with pending messages.
+    client_queue::depth_map queue_depths() const;
+
 private:
-    typedef std::unordered_map<std::string, command_handler> command_map;
+    struct command
+    {
+        command_handler handler;
+        statistics::command* stats;
+        request_class type;
+
+        // The key of the command in the map, stable for the worker's life.
+        const std::string* name;
+    };
+
+    typedef std::unordered_map<std::string, command> command_map;
+
+    struct pending_request
+    {
+        statistics::request::ptr timing;
+        request_trace::ptr trace;
+        request_class type;
+
+        // True until the reply releases the concurrency of the class.
+        bool running;
+
+        // True once the reply is queued for the client.
+        bool answered;
+    };
+
+    // Requests awaiting the send of their reply, by client and request id.
+    typedef std::pair<data_chunk, uint32_t> request_key;
+    typedef std::map<request_key, pending_request> request_map;
 
     void whitelist();
     bool enable_crypto();
     bool create_new_socket();
     void poll();
+    bool duplicate(const incoming_message& request) const;
+    void submit(const incoming_message& request, const command& handler);
+    void dispatch(const incoming_message& request, const command& handler,
+        statistics::request::ptr timing);
+    void shed(const incoming_message& request, const command& handler,
+        statistics::request::ptr timing);
+    queue_send_callback admit(const incoming_message& request,
+        const command& handler, statistics::request::ptr timing,
+        bool running);
+    void release(pending_request& pending);
+    void abandon(const request_key& key);
+    void handle_dequeued(const czmqpp::message& message);
+    void handle_sent(const czmqpp::message& message);
+    void expire_requests();
+    void serve_stats();
     void publish_heartbeat();
 
     czmqpp::context context_;
     czmqpp::socket socket_;
     czmqpp::socket wakeup_socket_;
     czmqpp::socket heartbeat_socket_;
+    czmqpp::socket stats_socket_;
     czmqpp::authenticator authenticate_;
 
     send_worker sender_;
+    client_queue outbound_;
     command_map handlers_;
+    statistics& stats_;
+    tracer tracer_;
+    request_recorder recorder_;
+    request_logger logger_;
+    request_scheduler scheduler_;
+    request_map pending_;
     boost::posix_time::ptime deadline_;
     const settings& settings_;
 };
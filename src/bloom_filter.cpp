@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/bloom_filter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/siphash.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// The optimal bits per element of a classic Bloom filter is -ln(p)/ln(2)^2
+// with ln(2) bits per hash. Blocking costs a little accuracy, so the filter
+// is given an eighth more bits than the classic optimum.
+static const double ln2 = std::log(2.0);
+static constexpr double blocking_overhead = 1.125;
+
+static size_t bits_for(size_t elements, double false_positive_rate)
+{
+    if (elements == 0)
+        return 0;
+
+    const auto rate = std::min(std::max(false_positive_rate, 1e-9), 0.5);
+    const auto bits_per_element = -std::log(rate) / (ln2 * ln2);
+    return static_cast<size_t>(std::ceil(
+        elements * bits_per_element * blocking_overhead));
+}
+
+static size_t hashes_for(double false_positive_rate)
+{
+    const auto rate = std::min(std::max(false_positive_rate, 1e-9), 0.5);
+    const auto hashes = std::round(-std::log(rate) / ln2);
+    return std::max(static_cast<size_t>(hashes), size_t(1));
+}
+
+bloom_filter::bloom_filter(size_t elements, double false_positive_rate)
+  : blocks_((bits_for(elements, false_positive_rate) + block_bits - 1) /
+        block_bits),
+    hashes_(hashes_for(false_positive_rate)),
+    words_(new std::atomic<uint64_t>[blocks_ * block_words]),
+    inserted_(0)
+{
+    for (size_t word = 0; word < blocks_ * block_words; ++word)
+        words_[word].store(0, std::memory_order_relaxed);
+
+    std::random_device device;
+    std::mt19937_64 engine(device());
+    block_key_ = { engine(), engine() };
+    bit_key_ = { engine(), engine() };
+}
+
+// Bits within the block are chosen by double hashing of one 64 bit hash.
+void bloom_filter::insert(data_slice key)
+{
+    if (!enabled())
+        return;
+
+    const auto block = siphash(block_key_, key) % blocks_;
+    const auto bits = siphash(bit_key_, key);
+    const auto first = static_cast<uint32_t>(bits);
+    const auto step = static_cast<uint32_t>(bits >> 32) | 1;
+    auto words = &words_[block * block_words];
+
+    for (size_t hash = 0; hash < hashes_; ++hash)
+    {
+        const auto bit = (first + hash * step) % block_bits;
+        words[bit / 64].fetch_or(uint64_t(1) << (bit % 64),
+            std::memory_order_relaxed);
+    }
+
+    ++inserted_;
+}
+
+bool bloom_filter::contains(data_slice key) const
+{
+    if (!enabled())
+        return true;
+
+    const auto block = siphash(block_key_, key) % blocks_;
+    const auto bits = siphash(bit_key_, key);
+    const auto first = static_cast<uint32_t>(bits);
+    const auto step = static_cast<uint32_t>(bits >> 32) | 1;
+    const auto words = &words_[block * block_words];
+
+    for (size_t hash = 0; hash < hashes_; ++hash)
+    {
+        const auto bit = (first + hash * step) % block_bits;
+        const auto word = words[bit / 64].load(std::memory_order_relaxed);
+        if ((word & (uint64_t(1) << (bit % 64))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool bloom_filter::enabled() const
+{
+    return blocks_ != 0;
+}
+
+size_t bloom_filter::size_bytes() const
+{
+    return blocks_ * block_bits / 8;
+}
+
+size_t bloom_filter::hash_count() const
+{
+    return hashes_;
+}
+
+uint64_t bloom_filter::inserted() const
+{
+    return inserted_;
+}
+
+// (1 - e^(-kn/m))^k, which understates the rate of a blocked filter a
+// little at high load.
+double bloom_filter::false_positive_rate() const
+{
+    if (!enabled())
+        return 1.0;
+
+    const auto bits = static_cast<double>(blocks_ * block_bits);
+    const auto load = hashes_ * static_cast<double>(inserted_) / bits;
+    return std::pow(1.0 - std::exp(-load), static_cast<double>(hashes_));
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/client_queue.hpp>
+
+#include <cerrno>
+#include <string>
+#include <boost/date_time.hpp>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/configuration.hpp>
+#include <bitcoin/server/config/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+client_queue::client_queue(const settings& settings, clock now)
+  : now_(now), settings_(settings)
+{
+}
+
+boost::posix_time::ptime client_queue::universal_time()
+{
+    return boost::posix_time::second_clock::universal_time();
+}
+
+void client_queue::set_disconnect_handler(disconnect_handler handler)
+{
+    disconnect_handler_ = handler;
+}
+
+void client_queue::set_sent_handler(sent_handler handler)
+{
+    sent_handler_ = handler;
+}
+
+// Subscription updates are the only unsolicited messages we send.
+static bool is_notification(const std::string& command)
+{
+    return command == "address.update" ||
+        command == "address.stealth_update" ||
+        command == "address.disconnect" ||
+        command == "address.stealth_disconnect";
+}
+
+void client_queue::enqueue(const czmqpp::message& message)
+{
+    const auto& parts = message.parts();
+    if (parts.size() != 4)
+    {
+        log::warning(LOG_SERVICE)
+            << "Invalid message size on send queue: " << parts.size();
+        return;
+    }
+
+    // [ DESTINATION ]
+    // The socket is mandatory-routed, so an empty identity is unreachable
+    // and would disconnect a client that does not exist.
+    auto it = parts.begin();
+    const auto origin = *it++;
+    if (origin.empty())
+    {
+        log::warning(LOG_SERVICE)
+            << "Dropping message without destination on send queue.";
+        return;
+    }
+
+    // [ COMMAND ]
+    const std::string command(it->begin(), it->end());
+
+    size_t bytes = 0;
+    for (const auto& part: parts)
+        bytes += part.size();
+
+    auto& queue = clients_[origin];
+
+    // The wait for progress starts when the queue becomes non-empty.
+    if (queue.entries.empty())
+        queue.last_progress = now_();
+
+    queue.entries.push_back({ message, bytes, is_notification(command) });
+    queue.bytes += bytes;
+    enforce_limits(origin, queue);
+}
+
+void client_queue::enforce_limits(const data_chunk& origin, client& queue)
+{
+    const auto exceeded = [this, &queue]()
+    {
+        return queue.entries.size() > settings_.outbound_queue_messages ||
+            queue.bytes > settings_.outbound_queue_bytes;
+    };
+
+    // Drop oldest notifications first, replies are never dropped.
+    for (auto it = queue.entries.begin();
+        it != queue.entries.end() && exceeded();)
+    {
+        if (!it->notification)
+        {
+            ++it;
+            continue;
+        }
+
+        queue.bytes -= it->bytes;
+        ++queue.dropped;
+        it = queue.entries.erase(it);
+    }
+
+    if (exceeded())
+        log::debug(LOG_SERVICE)
+            << "Outbound queue limit exceeded by replies to "
+            << encode_base16(origin) << " (" << queue.entries.size()
+            << " messages, " << queue.bytes << " bytes)";
+}
+
+void client_queue::flush(czmqpp::socket& socket)
+{
+    for (auto it = clients_.begin(); it != clients_.end();)
+    {
+        if (!flush(socket, it->second))
+        {
+            // Disconnect erases the client.
+            disconnect(it++);
+            continue;
+        }
+
+        if (it->second.entries.empty())
+        {
+            it = clients_.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+}
+
+// Returns false if the client should be disconnected.
+bool client_queue::flush(czmqpp::socket& socket, client& queue)
+{
+    while (!queue.entries.empty())
+    {
+        auto& front = queue.entries.front();
+
+        // The socket is mandatory-routed and non-blocking, so this fails
+        // with EAGAIN on a full peer pipe and EHOSTUNREACH on a lost peer.
+        if (!front.message.send(socket))
+        {
+            if (zmq_errno() == EHOSTUNREACH)
+                return false;
+
+            break;
+        }
+
+        if (sent_handler_)
+            sent_handler_(front.message);
+
+        queue.bytes -= front.bytes;
+        queue.entries.pop_front();
+        queue.last_progress = now_();
+    }
+
+    if (queue.entries.empty())
+        return true;
+
+    // Slow consumer, no progress within the timeout period.
+    const auto timeout = settings_.slow_client_timeout();
+    return now_() - queue.last_progress <= timeout;
+}
+
+void client_queue::disconnect(client_map::iterator it)
+{
+    const auto origin = it->first;
+    const auto& queue = it->second;
+
+    // The connection is left open, zeromq cannot close one router peer.
+    log::warning(LOG_SERVICE)
+        << "Dropping slow or lost client " << encode_base16(origin)
+        << " discarding " << queue.entries.size() << " messages ("
+        << queue.bytes << " bytes)";
+
+    clients_.erase(it);
+
+    if (disconnect_handler_)
+        disconnect_handler_(origin);
+}
+
+bool client_queue::pending() const
+{
+    return !clients_.empty();
+}
+
+client_queue::depth_map client_queue::depths() const
+{
+    depth_map depths;
+    for (const auto& item: clients_)
+    {
+        const auto& queue = item.second;
+        depths[item.first] =
+            { queue.entries.size(), queue.bytes, queue.dropped };
+    }
+
+    return depths;
+}
+
+} // namespace server
+} // namespace libbitcoin
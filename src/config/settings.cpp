@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <bitcoin/node.hpp>
@@ -348,6 +349,18 @@ const options_description parser::load_settings()
             default_value(SERVER_TRANSACTION_PUBLISH_ENDPOINT),
         "The transaction publishing service endpoint, defaults to 'tcp://*:9094'."
     )
+    (
+        "server.raw_block_publish_endpoint",
+        value<endpoint>(&settings.server.raw_block_publish_endpoint)->
+            default_value(SERVER_RAW_BLOCK_PUBLISH_ENDPOINT),
+        "The raw block publishing service endpoint, defaults to 'tcp://*:9095'."
+    )
+    (
+        "server.stats_endpoint",
+        value<endpoint>(&settings.server.stats_endpoint)->
+            default_value(SERVER_STATS_ENDPOINT),
+        "The statistics text endpoint, defaults to 'tcp://127.0.0.1:9096'."
+    )
     (
         "server.publisher_enabled",
         value<bool>(&settings.server.publisher_enabled)->
@@ -407,6 +420,192 @@ const options_description parser::load_settings()
         value<config::authority::list>(&settings.server.whitelists)->
             multitoken()->default_value(SERVER_WHITELISTS),
         "Allowed client IP address, all clients allowed if none set, multiple entries allowed."
+    )
+    (
+        "server.outbound_queue_messages",
+        value<uint32_t>(&settings.server.outbound_queue_messages)->
+            default_value(SERVER_OUTBOUND_QUEUE_MESSAGES),
+        "The maximum number of messages queued to a query client before notifications are dropped, defaults to 1000."
+    )
+    (
+        "server.outbound_queue_bytes",
+        value<uint32_t>(&settings.server.outbound_queue_bytes)->
+            default_value(SERVER_OUTBOUND_QUEUE_BYTES),
+        "The maximum number of bytes queued to a query client before notifications are dropped, defaults to 10000000."
+    )
+    (
+        "server.slow_client_timeout_seconds",
+        value<uint32_t>(&settings.server.slow_client_timeout_seconds)->
+            default_value(SERVER_SLOW_CLIENT_TIMEOUT_SECONDS),
+        "The time a query client may accept no messages before its queue and subscriptions are dropped, defaults to 60."
+    )
+    (
+        "server.transaction_cache_capacity",
+        value<uint32_t>(&settings.server.transaction_cache_capacity)->
+            default_value(SERVER_TRANSACTION_CACHE_CAPACITY),
+        "The maximum number of analyzed transactions shared by the notification services, defaults to 10000."
+    )
+    (
+        "server.notification_bus_capacity",
+        value<uint32_t>(&settings.server.notification_bus_capacity)->
+            default_value(SERVER_NOTIFICATION_BUS_CAPACITY),
+        "The number of block and transaction notifications buffered for each server service, beyond which a service that falls behind skips the oldest, defaults to 1024."
+    )
+    (
+        "server.publisher_topics",
+        value<bool>(&settings.server.publisher_topics)->
+            default_value(SERVER_PUBLISHER_TOPICS),
+        "Publish each transaction once per output address or stealth prefix topic, a subscriber to all topics receives each copy, defaults to false."
+    )
+    (
+        "server.publisher_sequence",
+        value<bool>(&settings.server.publisher_sequence)->
+            default_value(SERVER_PUBLISHER_SEQUENCE),
+        "Number published messages and retain them for replay, defaults to false."
+    )
+    (
+        "server.publisher_replay_capacity",
+        value<uint32_t>(&settings.server.publisher_replay_capacity)->
+            default_value(SERVER_PUBLISHER_REPLAY_CAPACITY),
+        "The number of recent messages retained for replay on each feed, defaults to 1000."
+    )
+    (
+        "server.publisher_compact_blocks",
+        value<bool>(&settings.server.publisher_compact_blocks)->
+            default_value(SERVER_PUBLISHER_COMPACT_BLOCKS),
+        "Publish blocks with short ids for transactions already published, defaults to false."
+    )
+    (
+        "server.publisher_compact_published_capacity",
+        value<uint32_t>(&settings.server.publisher_compact_published_capacity)->
+            default_value(SERVER_PUBLISHER_COMPACT_PUBLISHED_CAPACITY),
+        "The number of published transactions remembered for compact blocks, defaults to 50000."
+    )
+    (
+        "server.publisher_disconnects",
+        value<bool>(&settings.server.publisher_disconnects)->
+            default_value(SERVER_PUBLISHER_DISCONNECTS),
+        "Publish a disconnect message on the block feed for each block replaced by a reorganization, defaults to false."
+    )
+    (
+        "server.publisher_raw_blocks",
+        value<bool>(&settings.server.publisher_raw_blocks)->
+            default_value(SERVER_PUBLISHER_RAW_BLOCKS),
+        "Publish the raw serialization of each block on the raw block endpoint, defaults to false."
+    )
+    (
+        "server.hot_address_capacity",
+        value<uint32_t>(&settings.server.hot_address_capacity)->
+            default_value(SERVER_HOT_ADDRESS_CAPACITY),
+        "The number of most queried addresses with cached histories, defaults to 100 (0 disables)."
+    )
+    (
+        "server.negative_filter_addresses",
+        value<uint32_t>(&settings.server.negative_filter_addresses)->
+            default_value(SERVER_NEGATIVE_FILTER_ADDRESSES),
+        "The expected number of addresses in the history negative filter, defaults to 0 (disabled)."
+    )
+    (
+        "server.negative_filter_transactions",
+        value<uint32_t>(&settings.server.negative_filter_transactions)->
+            default_value(SERVER_NEGATIVE_FILTER_TRANSACTIONS),
+        "The expected number of transactions in the transaction negative filter, defaults to 0 (disabled)."
+    )
+    (
+        "server.negative_filter_spends",
+        value<uint32_t>(&settings.server.negative_filter_spends)->
+            default_value(SERVER_NEGATIVE_FILTER_SPENDS),
+        "The expected number of spent outputs in the spend negative filter, defaults to 0 (disabled)."
+    )
+    (
+        "server.negative_filter_false_positive_rate",
+        value<double>(&settings.server.negative_filter_false_positive_rate)->
+            default_value(SERVER_NEGATIVE_FILTER_FALSE_POSITIVE_RATE),
+        "The target false positive rate of the negative filters, defaults to 0.01."
+    )
+    (
+        "server.stats_enabled",
+        value<bool>(&settings.server.stats_enabled)->
+            default_value(SERVER_STATS_ENABLED),
+        "Serve request statistics as text on the statistics endpoint, defaults to false."
+    )
+    (
+        "server.trace_sample_interval",
+        value<uint32_t>(&settings.server.trace_sample_interval)->
+            default_value(SERVER_TRACE_SAMPLE_INTERVAL),
+        "Trace one in this many requests to the trace file, defaults to 0 (disabled)."
+    )
+    (
+        "server.trace_file",
+        value<path>(&settings.server.trace_file)->
+            default_value(SERVER_TRACE_FILE),
+        "The request trace file path, in Chrome trace event format, defaults to 'trace.json'."
+    )
+    (
+        "server.record_file",
+        value<path>(&settings.server.record_file)->
+            default_value(SERVER_RECORD_FILE),
+        "Record received requests to this file for replay with bs-replay, defaults to '' (disabled)."
+    )
+    (
+        "server.query_normal_concurrency",
+        value<uint32_t>(&settings.server.query_normal_concurrency)->
+            default_value(SERVER_QUERY_NORMAL_CONCURRENCY),
+        "The number of normal cost queries run at once, defaults to 16 (0 for unlimited)."
+    )
+    (
+        "server.query_expensive_concurrency",
+        value<uint32_t>(&settings.server.query_expensive_concurrency)->
+            default_value(SERVER_QUERY_EXPENSIVE_CONCURRENCY),
+        "The number of expensive queries such as history scans run at once, defaults to 4 (0 for unlimited)."
+    )
+    (
+        "server.query_delay_target_milliseconds",
+        value<uint32_t>(&settings.server.query_delay_target_milliseconds)->
+            default_value(SERVER_QUERY_DELAY_TARGET_MILLISECONDS),
+        "The queueing delay of deferred queries above which they are shed, defaults to 100."
+    )
+    (
+        "server.query_delay_interval_milliseconds",
+        value<uint32_t>(&settings.server.query_delay_interval_milliseconds)->
+            default_value(SERVER_QUERY_DELAY_INTERVAL_MILLISECONDS),
+        "The period queueing delay must exceed its target before queries are shed, defaults to 1000."
+    )
+    (
+        "server.query_rate_limit",
+        value<uint32_t>(&settings.server.query_rate_limit)->
+            default_value(SERVER_QUERY_RATE_LIMIT),
+        "The queries per second allowed each client, scaled by its weight, defaults to 0 (unlimited)."
+    )
+    (
+        "server.query_rate_burst",
+        value<uint32_t>(&settings.server.query_rate_burst)->
+            default_value(SERVER_QUERY_RATE_BURST),
+        "The queries a client may send at once above its rate limit, scaled by its weight, defaults to 20."
+    )
+    (
+        "server.query_client_weight",
+        value<std::vector<std::string>>(&settings.server.query_client_weights)->
+            multitoken()->default_value(SERVER_QUERY_CLIENT_WEIGHTS, ""),
+        "The scheduling and rate limit weight of a client, as its socket identity and weight separated by a colon, multiple entries allowed."
+    )
+    (
+        "server.log_request_sample_interval",
+        value<uint32_t>(&settings.server.log_request_sample_interval)->
+            default_value(SERVER_LOG_REQUEST_SAMPLE_INTERVAL),
+        "Log one in this many requests when log_requests is set, defaults to 1."
+    )
+    (
+        "server.log_request_capacity",
+        value<uint32_t>(&settings.server.log_request_capacity)->
+            default_value(SERVER_LOG_REQUEST_CAPACITY),
+        "The number of request log records buffered for the log writer, defaults to 65536."
+    )
+    (
+        "server.header_store_enabled",
+        value<bool>(&settings.server.header_store_enabled)->
+            default_value(SERVER_HEADER_STORE_ENABLED),
+        "Keep all block headers in memory to serve header ranges, defaults to true."
     );
 
     return description;
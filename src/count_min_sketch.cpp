@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/count_min_sketch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/siphash.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+count_min_sketch::count_min_sketch(size_t width, size_t depth,
+    uint64_t decay_interval)
+  : width_(std::max(width, size_t(1))),
+    decay_interval_(decay_interval),
+    counts_(width_ * std::max(depth, size_t(1)), 0),
+    increments_(0),
+    decayed_(false)
+{
+    std::random_device device;
+    std::mt19937_64 engine(device());
+
+    for (size_t row = 0; row < std::max(depth, size_t(1)); ++row)
+        keys_.push_back({ engine(), engine() });
+}
+
+size_t count_min_sketch::index(size_t row, data_slice key) const
+{
+    return row * width_ + siphash(keys_[row], key) % width_;
+}
+
+uint32_t count_min_sketch::increment(data_slice key)
+{
+    decayed_ = false;
+    if (decay_interval_ != 0 && ++increments_ % decay_interval_ == 0)
+        decay();
+
+    // Conservative update: only the minimal counters are raised, which
+    // reduces overcounting without ever undercounting.
+    const auto current = estimate(key);
+    if (current == max_uint32)
+        return current;
+
+    for (size_t row = 0; row < keys_.size(); ++row)
+    {
+        auto& count = counts_[index(row, key)];
+        count = std::max(count, current + 1);
+    }
+
+    return current + 1;
+}
+
+uint32_t count_min_sketch::estimate(data_slice key) const
+{
+    auto minimum = max_uint32;
+    for (size_t row = 0; row < keys_.size(); ++row)
+        minimum = std::min(minimum, counts_[index(row, key)]);
+
+    return minimum;
+}
+
+bool count_min_sketch::decayed() const
+{
+    return decayed_;
+}
+
+void count_min_sketch::decay()
+{
+    for (auto& count: counts_)
+        count >>= 1;
+
+    decayed_ = true;
+}
+
+} // namespace server
+} // namespace libbitcoin
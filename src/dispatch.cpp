@@ -188,8 +188,8 @@ static void interrupt_handler(int code)
 }
 
 // Attach client-server API.
-static void attach_api(request_worker& worker, server_node& node,
-    subscribe_manager& subscriber)
+void attach_api(request_worker& worker, server_node& node,
+    subscribe_manager& subscriber, publisher& publish)
 {
     typedef std::function<void(server_node&, const incoming_message&,
         queue_send_callback)> basic_command_handler;
@@ -209,13 +209,30 @@ static void attach_api(request_worker& worker, server_node& node,
         std::bind(&subscribe_manager::renew,
             &subscriber, _1, _2));
 
+    // Publisher gap recovery.
+    worker.attach("server.replay",
+        std::bind(&publisher::replay,
+            &publish, _1, _2));
+
+    worker.attach("server.fetch_compact_transactions",
+        std::bind(&publisher::fetch_compact_transactions,
+            &publish, _1, _2));
+
+    // Request and server statistics.
+    worker.attach("server.stats",
+        std::bind(&statistics::fetch,
+            &node.stats(), _1, _2));
+
     // Non-subscription API.
     attach("address.fetch_history2", server_node::fullnode_fetch_history);
     attach("blockchain.fetch_history", blockchain_fetch_history);
     attach("blockchain.fetch_transaction", blockchain_fetch_transaction);
+    attach("blockchain.fetch_transactions", blockchain_fetch_transactions);
+    attach("blockchain.fetch_transaction_with_prevouts", blockchain_fetch_transaction_with_prevouts);
     attach("blockchain.fetch_last_height", blockchain_fetch_last_height);
     attach("blockchain.fetch_block_header", blockchain_fetch_block_header);
-    ////attach("blockchain.fetch_block_transaction_hashes", blockchain_fetch_block_transaction_hashes);
+    attach("blockchain.fetch_block_headers", blockchain_fetch_block_headers);
+    attach("blockchain.fetch_block_transaction_hashes", blockchain_fetch_block_transaction_hashes);
     attach("blockchain.fetch_transaction_index", blockchain_fetch_transaction_index);
     attach("blockchain.fetch_spend", blockchain_fetch_spend);
     attach("blockchain.fetch_block_height", blockchain_fetch_block_height);
@@ -227,6 +244,11 @@ static void attach_api(request_worker& worker, server_node& node,
 
     // Deprecated command, for backward compatibility.
     attach("address.fetch_history", COMPAT_fetch_history);
+
+    // Slow clients lose their subscriptions when disconnected.
+    worker.set_disconnect_handler(
+        std::bind(&subscribe_manager::unsubscribe,
+            &subscriber, _1));
 }
 
 // Run the server.
@@ -257,6 +279,10 @@ static console_result run(const configuration& config, std::ostream& output,
         return console_result::not_started;
     }
 
+    // Loads in the background, lookups are unfiltered until complete.
+    server.filters().load(server.blockchain());
+    server.headers().load(server.blockchain());
+
     publisher publish(server, config.server);
     if (config.server.publisher_enabled)
     {
@@ -268,7 +294,7 @@ static console_result run(const configuration& config, std::ostream& output,
         }
     }
 
-    request_worker worker(config.server);
+    request_worker worker(server.stats(), config.server);
     subscribe_manager subscriber(server, config.server);
     if (config.server.queries_enabled)
     {
@@ -278,7 +304,7 @@ static console_result run(const configuration& config, std::ostream& output,
             return console_result::not_started;
         }
 
-        attach_api(worker, server, subscriber);
+        attach_api(worker, server, subscriber, publish);
     }
 
     output << BS_SERVER_STARTED << std::endl;
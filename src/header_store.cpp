@@ -0,0 +1,284 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/header_store.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::blockchain;
+using namespace bc::chain;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+// Log progress of the startup walk every this many headers.
+static constexpr size_t load_progress_interval = 50000;
+
+// The lookups in flight during the startup walk.
+static constexpr size_t load_batch_size = 500;
+
+// Room for about four weeks of blocks beyond the top at startup.
+static constexpr size_t reserve_blocks = 4032;
+
+header_store::header_store(const settings& settings)
+  : enabled_(settings.header_store_enabled),
+    notified_top_(0),
+    ready_(false),
+    stopped_(false)
+{
+}
+
+header_store::~header_store()
+{
+    stopped_ = true;
+    guard_.close();
+}
+
+void header_store::load(block_chain& chain)
+{
+    if (!enabled_)
+        return;
+
+    chain.fetch_last_height(guard_.wrap(
+        std::bind(&header_store::handle_last_height,
+            this, _1, _2, std::ref(chain))));
+}
+
+void header_store::handle_last_height(const code& ec, size_t last_height,
+    block_chain& chain)
+{
+    if (ec)
+    {
+        log::error(LOG_SERVICE)
+            << "Header store not loaded: " << ec.message();
+        return;
+    }
+
+    log::info(LOG_SERVICE)
+        << "Loading header store to block " << last_height;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        headers_.reserve((last_height + 1 + reserve_blocks) * header_size);
+    }
+
+    load_batch(chain);
+}
+
+// The lookups of a batch, each written by its own lookup, with the batch
+// appended by the last lookup to complete.
+struct header_store::batch
+{
+    batch(size_t start, size_t count)
+      : start(start), results(count), remaining(count)
+    {
+    }
+
+    const size_t start;
+    std::vector<std::pair<code, header>> results;
+    std::atomic<size_t> remaining;
+};
+
+// Batches are read from the top of the store, so the walk continues past
+// blocks accepted since it started and resumes below a header dropped by a
+// reorganization.
+void header_store::load_batch(block_chain& chain)
+{
+    if (stopped_)
+        return;
+
+    const auto headers = std::make_shared<batch>(size(), load_batch_size);
+    for (size_t index = 0; index < load_batch_size; ++index)
+        chain.fetch_block_header(headers->start + index, guard_.wrap(
+            std::bind(&header_store::handle_header,
+                this, _1, _2, index, headers, std::ref(chain))));
+}
+
+void header_store::handle_header(const code& ec, const header& header,
+    size_t index, batch_ptr headers, block_chain& chain)
+{
+    headers->results[index] = { ec, header };
+    if (--headers->remaining == 0)
+        handle_batch(headers, chain);
+}
+
+void header_store::handle_batch(batch_ptr headers, block_chain& chain)
+{
+    auto height = headers->start;
+    auto ec = code();
+    auto top = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& result: headers->results)
+        {
+            ec = result.first;
+            if (ec || !append(height, result.second))
+                break;
+
+            ++height;
+        }
+
+        // A block accepted during the batch was left to the walk.
+        top = ec == bc::error::not_found && height > notified_top_;
+    }
+
+    if (ec == bc::error::service_stopped)
+        return;
+
+    // Blocks above the top are appended by the node as they are accepted.
+    if (top)
+    {
+        ready_ = true;
+        log::info(LOG_SERVICE)
+            << "Header store loaded to block " << height - 1 << ", "
+            << height * header_size << " bytes";
+        return;
+    }
+
+    if (ec && ec != bc::error::not_found)
+    {
+        log::error(LOG_SERVICE)
+            << "Header store not loaded, block " << height << ": "
+            << ec.message();
+        return;
+    }
+
+    if (height / load_progress_interval !=
+        headers->start / load_progress_interval)
+        log::debug(LOG_SERVICE)
+            << "Loading header store, block " << height;
+
+    load_batch(chain);
+}
+
+void header_store::reorganize(uint64_t fork_point,
+    const block_chain::list& new_blocks)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    notified_top_ = fork_point + new_blocks.size();
+
+    // Blocks above a store still loading are left to the walk.
+    auto height = fork_point + 1;
+    if (stored() < height)
+        return;
+
+    headers_.resize(height * header_size);
+    for (const auto& block: new_blocks)
+        if (!append(height++, block->header))
+            return;
+}
+
+bool header_store::read(size_t start, size_t count, data_chunk& out) const
+{
+    if (!enabled_)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto top = stored();
+    const auto available = start < top ? std::min(count, top - start) : 0;
+
+    // Until loaded the top of the store is not the top of the chain.
+    if (available < count && !ready_)
+        return false;
+
+    // A start above the top is answered empty.
+    if (available == 0)
+        return true;
+
+    const auto first = headers_.begin() + start * header_size;
+    out.insert(out.end(), first, first + available * header_size);
+    return true;
+}
+
+bool header_store::block_hash(size_t height, hash_digest& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (height >= stored())
+        return false;
+
+    const auto first = headers_.data() + height * header_size;
+    out = bitcoin_hash(data_slice(first, first + header_size));
+    return true;
+}
+
+bool header_store::enabled() const
+{
+    return enabled_;
+}
+
+bool header_store::ready() const
+{
+    return ready_;
+}
+
+size_t header_store::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stored();
+}
+
+size_t header_store::stored() const
+{
+    return headers_.size() / header_size;
+}
+
+// A header is appended only at the top, and only if it links to the header
+// below it. One that does not link drops the header below, which was
+// replaced by a reorganization the store has not seen.
+bool header_store::append(size_t height, const header& header)
+{
+    const auto top = stored();
+    if (height != top)
+        return false;
+
+    if (top > 0)
+    {
+        const auto below = headers_.data() + (top - 1) * header_size;
+        const data_slice previous(below, below + header_size);
+        if (header.previous_block_hash != bitcoin_hash(previous))
+        {
+            headers_.resize((top - 1) * header_size);
+            return false;
+        }
+    }
+
+    extend_data(headers_, header.to_data(false));
+    return true;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/hot_address_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/count_min_sketch.hpp>
+#include <bitcoin/server/transaction_cache.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// Keep the sketch wide relative to K so that estimates at the cache
+// boundary are dominated by real counts rather than collisions.
+static constexpr size_t sketch_width_per_entry = 64;
+static constexpr size_t sketch_minimum_width = 1024;
+static constexpr size_t sketch_depth = 4;
+
+// Halve all counts after this many queries per sketch column.
+static constexpr uint64_t decay_per_column = 8;
+
+// A single query never makes an address hot.
+static constexpr uint32_t admission_threshold = 2;
+
+static size_t sketch_width(size_t capacity)
+{
+    return std::max(capacity * sketch_width_per_entry, sketch_minimum_width);
+}
+
+hot_address_cache::hot_address_cache(size_t capacity)
+  : capacity_(capacity),
+    sketch_(sketch_width(capacity), sketch_depth,
+        sketch_width(capacity) * decay_per_column),
+    floor_(0),
+    generation_(0),
+    size_(0),
+    hits_(0),
+    misses_(0)
+{
+}
+
+bool hot_address_cache::record(const short_hash& hash)
+{
+    if (capacity_ == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto estimate = sketch_.increment(hash);
+
+    // Keep tracked estimates on the same scale as the sketch.
+    if (sketch_.decayed())
+    {
+        for (auto& item: entries_)
+            item.second.estimate >>= 1;
+
+        floor_ = 0;
+    }
+
+    const auto it = entries_.find(hash);
+    if (it != entries_.end())
+    {
+        it->second.estimate = estimate;
+        return true;
+    }
+
+    if (estimate < admission_threshold)
+        return false;
+
+    if (entries_.size() < capacity_)
+    {
+        admit(hash, estimate);
+        return true;
+    }
+
+    // The floor is a lower bound of the coldest tracked estimate.
+    if (estimate <= floor_)
+        return false;
+
+    const auto coldest = std::min_element(entries_.begin(), entries_.end(),
+        [](const entry_map::value_type& left,
+            const entry_map::value_type& right)
+        {
+            return left.second.estimate < right.second.estimate;
+        });
+
+    floor_ = coldest->second.estimate;
+    if (estimate <= floor_)
+        return false;
+
+    entries_.erase(coldest);
+    admit(hash, estimate);
+    return true;
+}
+
+void hot_address_cache::admit(const short_hash& hash, uint32_t estimate)
+{
+    entry& admitted = entries_[hash];
+    admitted.estimate = estimate;
+    admitted.generation = ++generation_;
+    std::fill(std::begin(admitted.cached), std::end(admitted.cached), false);
+    size_ = entries_.size();
+}
+
+bool hot_address_cache::fetch(const short_hash& hash, source from,
+    result& out, uint64_t& generation)
+{
+    const auto index = static_cast<size_t>(from);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(hash);
+    if (it == entries_.end())
+    {
+        generation = 0;
+        return false;
+    }
+
+    const auto& cached = it->second;
+    if (!cached.cached[index])
+    {
+        ++misses_;
+        generation = cached.generation;
+        return false;
+    }
+
+    ++hits_;
+    out = cached.results[index];
+    return true;
+}
+
+void hot_address_cache::store(const short_hash& hash, source from,
+    uint64_t generation, history_ptr history, const data_chunk& payload)
+{
+    const auto index = static_cast<size_t>(from);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(hash);
+
+    // Evicted, or a transaction arrived while the database was read.
+    if (it == entries_.end() || it->second.generation != generation)
+        return;
+
+    it->second.cached[index] = true;
+    it->second.results[index] = { history, payload };
+}
+
+void hot_address_cache::invalidate(const transaction_analysis& tx)
+{
+    if (empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& address: tx.input_addresses)
+        invalidate(address);
+
+    for (const auto& address: tx.output_addresses)
+        invalidate(address);
+}
+
+void hot_address_cache::invalidate(const wallet::payment_address& address)
+{
+    const auto it = entries_.find(address.hash());
+    if (it == entries_.end())
+        return;
+
+    auto& stale = it->second;
+    stale.generation = ++generation_;
+    for (size_t index = 0; index < sources; ++index)
+    {
+        stale.cached[index] = false;
+        stale.results[index] = result();
+    }
+}
+
+bool hot_address_cache::empty() const
+{
+    return size_ == 0;
+}
+
+size_t hot_address_cache::hits() const
+{
+    return hits_;
+}
+
+size_t hot_address_cache::misses() const
+{
+    return misses_;
+}
+
+} // namespace server
+} // namespace libbitcoin
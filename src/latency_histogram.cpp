@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/latency_histogram.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace libbitcoin {
+namespace server {
+
+constexpr size_t latency_histogram::linear_buckets;
+constexpr size_t latency_histogram::half_buckets;
+constexpr uint64_t latency_histogram::largest;
+constexpr size_t latency_histogram::buckets;
+
+latency_histogram::latency_histogram()
+  : count_(0), sum_(0), maximum_(0)
+{
+    for (auto& count: counts_)
+        count.store(0, std::memory_order_relaxed);
+}
+
+// A value of [64 << shift, 128 << shift) falls in bucket 64 * shift plus
+// its top seven bits, which continues the linear range without a gap.
+size_t latency_histogram::index(uint64_t value)
+{
+    value = std::min(value, largest);
+    size_t shift = 0;
+    while ((value >> shift) >= linear_buckets)
+        ++shift;
+
+    return half_buckets * shift + static_cast<size_t>(value >> shift);
+}
+
+uint64_t latency_histogram::lower(size_t index)
+{
+    if (index < linear_buckets)
+        return index;
+
+    const auto shift = index / half_buckets - 1;
+    const uint64_t top = index % half_buckets + half_buckets;
+    return top << shift;
+}
+
+uint64_t latency_histogram::upper(size_t index)
+{
+    return index + 1 < buckets ? lower(index + 1) - 1 : largest;
+}
+
+void latency_histogram::record(uint64_t microseconds)
+{
+    counts_[index(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(microseconds, std::memory_order_relaxed);
+
+    auto maximum = maximum_.load(std::memory_order_relaxed);
+    while (microseconds > maximum && !maximum_.compare_exchange_weak(
+        maximum, microseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t latency_histogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::sum() const
+{
+    return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::maximum() const
+{
+    return maximum_.load(std::memory_order_relaxed);
+}
+
+// Buckets are read without a snapshot, so concurrent records may shift a
+// quantile by a bucket but never past the recorded maximum.
+uint64_t latency_histogram::quantile(double fraction) const
+{
+    uint64_t total = 0;
+    for (const auto& count: counts_)
+        total += count.load(std::memory_order_relaxed);
+
+    if (total == 0)
+        return 0;
+
+    fraction = std::min(std::max(fraction, 0.0), 1.0);
+    const auto target = std::max(static_cast<uint64_t>(
+        std::ceil(fraction * total)), uint64_t(1));
+
+    uint64_t cumulative = 0;
+    for (size_t bucket = 0; bucket < buckets; ++bucket)
+    {
+        cumulative += counts_[bucket].load(std::memory_order_relaxed);
+        if (cumulative >= target)
+            return std::min(upper(bucket), maximum());
+    }
+
+    return maximum();
+}
+
+} // namespace server
+} // namespace libbitcoin
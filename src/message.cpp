@@ -20,6 +20,7 @@
 #include <bitcoin/server/message.hpp>
 
 #include <random>
+#include <utility>
 
 namespace libbitcoin {
 namespace server {
@@ -78,6 +79,22 @@ const data_chunk& incoming_message::data() const
     return data_;
 }
 
+void incoming_message::set_trace(request_trace::ptr trace)
+{
+    trace_ = trace;
+}
+
+const request_trace::ptr& incoming_message::trace() const
+{
+    return trace_;
+}
+
+void incoming_message::stamp(request_trace::point at) const
+{
+    if (trace_)
+        trace_->stamp(at);
+}
+
 outgoing_message::outgoing_message()
 {
 }
@@ -97,6 +114,13 @@ outgoing_message::outgoing_message(
 {
 }
 
+outgoing_message::outgoing_message(
+    const incoming_message& request, data_chunk&& data)
+  : dest_(request.origin()), command_(request.command()),
+    id_(request.id()), data_(std::move(data))
+{
+}
+
 void append_str(czmqpp::message& message, const std::string& command)
 {
     message.append(data_chunk(command.begin(), command.end()));
@@ -130,5 +154,10 @@ uint32_t outgoing_message::id() const
     return id_;
 }
 
+const data_chunk& outgoing_message::data() const
+{
+    return data_;
+}
+
 } // namespace server
 } // namespace libbitcoin
@@ -0,0 +1,220 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/negative_filters.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/bloom_filter.hpp>
+#include <bitcoin/server/config/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::blockchain;
+using namespace bc::chain;
+using namespace bc::wallet;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+// Log progress of the startup walk every this many blocks.
+static constexpr size_t load_progress_interval = 10000;
+
+negative_filters::negative_filters(const settings& settings)
+  : addresses_(settings.negative_filter_addresses,
+        settings.negative_filter_false_positive_rate),
+    transactions_(settings.negative_filter_transactions,
+        settings.negative_filter_false_positive_rate),
+    spends_(settings.negative_filter_spends,
+        settings.negative_filter_false_positive_rate),
+    ready_(false),
+    stopped_(false),
+    negatives_(0)
+{
+}
+
+negative_filters::~negative_filters()
+{
+    stopped_ = true;
+    guard_.close();
+}
+
+void negative_filters::load(block_chain& chain)
+{
+    if (!enabled())
+        return;
+
+    chain.fetch_last_height(guard_.wrap(
+        std::bind(&negative_filters::handle_last_height,
+            this, _1, _2, std::ref(chain))));
+}
+
+void negative_filters::handle_last_height(const code& ec,
+    size_t last_height, block_chain& chain)
+{
+    if (ec)
+    {
+        log::error(LOG_SERVICE)
+            << "Negative filters not loaded: " << ec.message();
+        return;
+    }
+
+    log::info(LOG_SERVICE)
+        << "Loading negative filters to block " << last_height;
+
+    // Blocks accepted from here on are inserted by the node.
+    load_block(0, last_height, chain);
+}
+
+// Blocks are read one at a time, which bounds memory and leaves the
+// blockchain threads to queries.
+void negative_filters::load_block(size_t height, size_t last_height,
+    block_chain& chain)
+{
+    if (stopped_)
+        return;
+
+    fetch_block(chain, height, guard_.wrap(
+        std::bind(&negative_filters::handle_block,
+            this, _1, _2, height, last_height, std::ref(chain))));
+}
+
+void negative_filters::handle_block(const code& ec, const block& block,
+    size_t height, size_t last_height, block_chain& chain)
+{
+    if (ec == bc::error::service_stopped)
+        return;
+
+    if (ec)
+    {
+        log::error(LOG_SERVICE)
+            << "Negative filters not loaded, block " << height << ": "
+            << ec.message();
+        return;
+    }
+
+    for (const auto& tx: block.transactions)
+        insert(tx, tx.hash());
+
+    if (height == last_height)
+    {
+        ready_ = true;
+        log_status();
+        return;
+    }
+
+    if (height % load_progress_interval == 0)
+        log::debug(LOG_SERVICE)
+            << "Loading negative filters, block " << height;
+
+    load_block(height + 1, last_height, chain);
+}
+
+// The history index keys on the addresses extracted from both input and
+// output scripts, so both are inserted.
+void negative_filters::insert(const transaction& tx, const hash_digest& hash)
+{
+    if (!enabled())
+        return;
+
+    transactions_.insert(hash);
+
+    for (const auto& input: tx.inputs)
+    {
+        spends_.insert(input.previous_output.to_data());
+
+        const auto address = payment_address::extract(input.script);
+        if (address)
+            addresses_.insert(address.hash());
+    }
+
+    for (const auto& output: tx.outputs)
+    {
+        const auto address = payment_address::extract(output.script);
+        if (address)
+            addresses_.insert(address.hash());
+    }
+}
+
+bool negative_filters::may_have_history(const short_hash& address_hash)
+{
+    return found(addresses_, address_hash);
+}
+
+bool negative_filters::may_have_transaction(const hash_digest& tx_hash)
+{
+    return found(transactions_, tx_hash);
+}
+
+bool negative_filters::may_be_spent(const output_point& outpoint)
+{
+    return found(spends_, outpoint.to_data());
+}
+
+bool negative_filters::found(const bloom_filter& filter, data_slice key)
+{
+    if (!ready_ || filter.contains(key))
+        return true;
+
+    ++negatives_;
+    return false;
+}
+
+bool negative_filters::enabled() const
+{
+    return addresses_.enabled() || transactions_.enabled() ||
+        spends_.enabled();
+}
+
+bool negative_filters::ready() const
+{
+    return ready_;
+}
+
+size_t negative_filters::negatives() const
+{
+    return negatives_;
+}
+
+void negative_filters::log_status() const
+{
+    const auto report = [](const char* name, const bloom_filter& filter)
+    {
+        if (!filter.enabled())
+            return;
+
+        log::info(LOG_SERVICE)
+            << "Negative filter " << name << ": " << filter.inserted()
+            << " keys in " << filter.size_bytes() << " bytes, "
+            << filter.hash_count() << " hashes, false positive rate "
+            << filter.false_positive_rate();
+    };
+
+    report("addresses", addresses_);
+    report("transactions", transactions_);
+    report("spends", spends_);
+
+    log::info(LOG_SERVICE)
+        << "Negative filters " << (ready_ ? "ready" : "loading") << ", "
+        << negatives_ << " lookups answered";
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,342 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/notification_bus.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// Bounds the cost of a missed wakeup.
+static const auto idle_timeout = std::chrono::milliseconds(100);
+
+// The number of empty polls by a yielding consumer before it sleeps.
+static constexpr size_t yield_spins = 1000;
+
+static uint64_t round_up(size_t value)
+{
+    uint64_t power = 2;
+    while (power < value)
+        power <<= 1;
+
+    return power;
+}
+
+notification_bus::consumer::consumer(const std::string& name, handler handle,
+    wait_strategy strategy, overflow_policy overflow, size_t batch_size,
+    uint64_t start)
+  : name(name),
+    handle(handle),
+    strategy(strategy),
+    overflow(overflow),
+    batch_size(std::max(batch_size, size_t(1))),
+    cursor(start),
+    processed(0),
+    batches(0),
+    dropped(0),
+    stopped(false)
+{
+}
+
+notification_bus::notification_bus(size_t capacity)
+  : mask_(round_up(capacity) - 1),
+    ring_(new entry_ptr[mask_ + 1]),
+    published_(0),
+    next_id_(0),
+    released_(0),
+    consumer_count_(0),
+    sleepers_(0)
+{
+}
+
+notification_bus::~notification_bus()
+{
+    stop();
+}
+
+notification_bus::consumer_id notification_bus::subscribe(
+    const std::string& name, handler handle, wait_strategy strategy,
+    overflow_policy overflow, size_t batch_size)
+{
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+
+    // The consumer starts at the next notification to be published.
+    const auto start = published_.load(std::memory_order_relaxed);
+    const auto reader = std::make_shared<consumer>(name, handle, strategy,
+        overflow, batch_size, start);
+
+    const auto id = next_id_++;
+    consumers_.emplace(id, reader);
+    consumer_count_.store(consumers_.size(), std::memory_order_relaxed);
+    reader->thread = std::thread(&notification_bus::run, this, reader);
+    return id;
+}
+
+void notification_bus::unsubscribe(consumer_id id)
+{
+    consumer_ptr reader;
+
+    {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        const auto it = consumers_.find(id);
+        if (it == consumers_.end())
+            return;
+
+        reader = it->second;
+    }
+
+    // The consumer bounds the slots released until it has stopped reading.
+    join(reader);
+
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+    consumers_.erase(id);
+    consumer_count_.store(consumers_.size(), std::memory_order_relaxed);
+}
+
+void notification_bus::stop()
+{
+    consumer_map stopping;
+
+    {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        stopping = consumers_;
+    }
+
+    for (const auto& item: stopping)
+        join(item.second);
+
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+    for (const auto& item: stopping)
+        consumers_.erase(item.first);
+
+    consumer_count_.store(consumers_.size(), std::memory_order_relaxed);
+}
+
+void notification_bus::join(consumer_ptr reader)
+{
+    reader->stopped.store(true);
+
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        wakeup_.notify_all();
+    }
+
+    if (reader->thread.joinable())
+        reader->thread.join();
+}
+
+bool notification_bus::subscribed() const
+{
+    return consumer_count_.load(std::memory_order_relaxed) != 0;
+}
+
+// Producer.
+// ----------------------------------------------------------------------------
+
+// The sequence below which every consumer has read, guarded by the caller.
+uint64_t notification_bus::gate(uint64_t next) const
+{
+    auto minimum = next;
+    for (const auto& item: consumers_)
+        minimum = std::min(minimum,
+            item.second->cursor.load(std::memory_order_acquire));
+
+    return minimum;
+}
+
+// The entry is allocated before the lock, which then guards only the slot
+// writes, so the node thread publishes a pointer and returns.
+void notification_bus::publish(notification&& item)
+{
+    if (!subscribed())
+        return;
+
+    auto published = std::make_shared<entry>();
+    published->item = std::move(item);
+
+    {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        if (consumers_.empty())
+            return;
+
+        const auto next = published_.load(std::memory_order_relaxed);
+        const auto capacity = mask_ + 1;
+
+        // Release the slots all consumers have passed, so that blocks are
+        // not retained by the ring until their slots are reused. Slots
+        // below a full ring have been reused, and are not released again.
+        if (next >= capacity)
+            released_ = std::max(released_, next - capacity);
+
+        for (const auto minimum = gate(next); released_ < minimum;
+            ++released_)
+            std::atomic_store(&ring_[released_ & mask_], entry_ptr());
+
+        published->sequence = next;
+        std::atomic_store(&ring_[next & mask_], entry_ptr(published));
+        published_.store(next + 1, std::memory_order_release);
+    }
+
+    signal();
+}
+
+void notification_bus::signal()
+{
+    // Pairs with the fence in wait(), one side always sees the other.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    wakeup_.notify_all();
+}
+
+// Consumers.
+// ----------------------------------------------------------------------------
+
+void notification_bus::run(consumer_ptr reader)
+{
+    const auto capacity = mask_ + 1;
+    auto cursor = reader->cursor.load(std::memory_order_relaxed);
+    size_t spins = 0;
+
+    while (!reader->stopped.load(std::memory_order_relaxed))
+    {
+        const auto available = published_.load(std::memory_order_acquire);
+        if (available == cursor)
+        {
+            wait(*reader, cursor, spins);
+            continue;
+        }
+
+        // A consumer more than a full ring behind has been overrun.
+        spins = 0;
+        uint64_t dropped = 0;
+        if (available - cursor > capacity)
+        {
+            dropped = available - capacity - cursor;
+            cursor = available - capacity;
+        }
+
+        // Publish the cursor once per batch rather than per notification.
+        uint64_t handled = 0;
+        const auto end = std::min(available, cursor + reader->batch_size);
+        for (auto sequence = cursor; sequence < end; ++sequence)
+        {
+            // The slot may be overwritten since the ring was checked.
+            const auto slot = std::atomic_load(&ring_[sequence & mask_]);
+            if (!slot || slot->sequence != sequence ||
+                shed(*reader, slot->item, sequence, available))
+            {
+                ++dropped;
+                continue;
+            }
+
+            reader->handle(slot->item);
+            ++handled;
+        }
+
+        reader->processed.fetch_add(handled, std::memory_order_relaxed);
+        reader->dropped.fetch_add(dropped, std::memory_order_relaxed);
+        reader->batches.fetch_add(1, std::memory_order_relaxed);
+        reader->cursor.store(end, std::memory_order_release);
+        cursor = end;
+    }
+}
+
+// Only transactions are shed, and only by a consumer that is subscribed to
+// shed them and is more than half a ring behind the producer.
+bool notification_bus::shed(const consumer& reader, const notification& item,
+    uint64_t sequence, uint64_t available) const
+{
+    return reader.overflow == overflow_policy::shed_transactions &&
+        item.type == notification::kind::transaction &&
+        available - sequence > mask_ / 2;
+}
+
+void notification_bus::wait(consumer& reader, uint64_t cursor,
+    size_t& spins)
+{
+    if (reader.strategy == wait_strategy::yielding && spins < yield_spins)
+    {
+        ++spins;
+        std::this_thread::yield();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    ++sleepers_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (published_.load(std::memory_order_relaxed) == cursor &&
+        !reader.stopped.load(std::memory_order_relaxed))
+        wakeup_.wait_for(lock, idle_timeout);
+
+    --sleepers_;
+}
+
+// Statistics.
+// ----------------------------------------------------------------------------
+
+notification_bus::status_list notification_bus::status() const
+{
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+    const auto next = published_.load(std::memory_order_relaxed);
+
+    status_list result;
+    result.reserve(consumers_.size());
+    for (const auto& item: consumers_)
+    {
+        const auto& reader = *item.second;
+        const auto cursor = reader.cursor.load(std::memory_order_acquire);
+        result.push_back(
+        {
+            reader.name,
+            next - cursor,
+            reader.processed.load(std::memory_order_relaxed),
+            reader.batches.load(std::memory_order_relaxed),
+            reader.dropped.load(std::memory_order_relaxed)
+        });
+    }
+
+    return result;
+}
+
+uint64_t notification_bus::dropped() const
+{
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+
+    uint64_t total = 0;
+    for (const auto& item: consumers_)
+        total += item.second->dropped.load(std::memory_order_relaxed);
+
+    return total;
+}
+
+} // namespace server
+} // namespace libbitcoin
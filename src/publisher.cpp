@@ -19,35 +19,75 @@
  */
 #include <bitcoin/server/publisher.hpp>
 
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <set>
 #include <string>
+#include <utility>
+#include <bitcoin/server/config/configuration.hpp>
 #include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/notification_bus.hpp>
+#include <bitcoin/server/replay_buffer.hpp>
+#include <bitcoin/server/siphash.hpp>
+#include <bitcoin/server/subscribe_manager.hpp>
+#include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
 namespace server {
 
 using std::placeholders::_1;
-using std::placeholders::_2;
 constexpr int zmq_fail = -1;
+constexpr int zmq_receive_no_wait = 0;
+
+// XPUB subscription messages are prefixed by one of these.
+constexpr uint8_t xpub_unsubscribe = 0;
+constexpr uint8_t xpub_subscribe = 1;
+
+publisher::feed::feed(size_t replay_capacity)
+  : sequence(0), replay(replay_capacity)
+{
+}
+
+// Socket writes are cheap relative to a wakeup, so drain in large batches.
+static constexpr size_t publisher_batch_size = 64;
+
+// The number of compact blocks retained for missing transaction queries.
+static constexpr size_t compact_block_history = 16;
+
+// BIP152 short transaction ids are 6 bytes.
+static constexpr size_t short_id_size = 6;
 
 publisher::publisher(server_node& node, const settings& settings)
   : node_(node),
     settings_(settings),
-    socket_block_(context_, ZMQ_PUB),
-    socket_tx_(context_, ZMQ_PUB)
+    socket_block_(context_, ZMQ_XPUB),
+    socket_tx_(context_, ZMQ_XPUB),
+    socket_raw_block_(context_, ZMQ_XPUB),
+    block_feed_(settings.publisher_replay_capacity),
+    tx_feed_(settings.publisher_replay_capacity),
+    raw_block_feed_(settings.publisher_replay_capacity),
+    consumer_(0),
+    started_(false)
+{
+}
+
+publisher::~publisher()
 {
+    stop();
 }
 
 bool publisher::setup_socket(const std::string& connection,
     czmqpp::socket& socket)
 {
+    // Subscription messages are drained without blocking before each send.
+    zsocket_set_rcvtimeo(socket.self(), zmq_receive_no_wait);
     return connection.empty() || socket.bind(connection) != zmq_fail;
 }
 
 bool publisher::start()
 {
-    node_.subscribe_blocks(std::bind(&publisher::send_block, this, _1, _2));
-    node_.subscribe_transactions(std::bind(&publisher::send_tx, this, _1));
-
     log::debug(LOG_PUBLISHER) << "Publishing blocks on "
         << settings_.block_publish_endpoint;
     if (!setup_socket(settings_.block_publish_endpoint.to_string(),
@@ -60,21 +100,113 @@ bool publisher::start()
         socket_tx_))
         return false;
 
+    if (settings_.publisher_raw_blocks)
+    {
+        log::debug(LOG_PUBLISHER) << "Publishing raw blocks on "
+            << settings_.raw_block_publish_endpoint;
+        if (!setup_socket(settings_.raw_block_publish_endpoint.to_string(),
+            socket_raw_block_))
+            return false;
+    }
+
+    // The sockets are used only by the consumer thread from here on.
+    consumer_ = node_.notifications().subscribe("publisher",
+        std::bind(&publisher::receive, this, _1),
+        notification_bus::wait_strategy::blocking,
+        notification_bus::overflow_policy::shed_transactions,
+        publisher_batch_size);
+
+    started_ = true;
     return true;
 }
 
 bool publisher::stop()
 {
+    if (started_)
+        node_.notifications().unsubscribe(consumer_);
+
+    started_ = false;
     return true;
 }
 
-static void append_hash(czmqpp::message& message, const hash_digest& hash)
+// Consumer thread.
+// ----------------------------------------------------------------------------
+
+void publisher::receive(const notification& item)
+{
+    switch (item.type)
+    {
+        case notification::kind::block:
+            send_block(item.height, *item.block, item.analyses);
+            if (settings_.publisher_raw_blocks)
+                send_raw_block(item.height, *item.block, item.analyses);
+            break;
+        case notification::kind::disconnect:
+            if (settings_.publisher_disconnects)
+                send_disconnect(item.height, *item.block, item.analyses);
+            break;
+        case notification::kind::transaction:
+            send_tx(*item.tx, item.analysis);
+            break;
+    }
+}
+
+static data_chunk to_frame(const hash_digest& hash)
 {
-    message.append(data_chunk(hash.begin(), hash.end()));
+    return data_chunk(hash.begin(), hash.end());
 }
 
-void publisher::send_block(uint32_t height, const chain::block& block)
+// Topics are prefixed with the subscribe_type, so that a subscription to a
+// partial address hash cannot match a stealth prefix or the reverse.
+static data_chunk address_topic(const wallet::payment_address& address)
 {
+    const auto& hash = address.hash();
+    data_chunk topic(1 + short_hash_size);
+    topic[0] = static_cast<uint8_t>(subscribe_type::address);
+    std::copy(hash.begin(), hash.end(), topic.begin() + 1);
+    return topic;
+}
+
+// The stealth prefix is little endian, consistent with stealth subscriptions.
+static data_chunk stealth_topic(uint32_t prefix)
+{
+    const auto bytes = to_little_endian(prefix);
+    data_chunk topic(1 + bytes.size());
+    topic[0] = static_cast<uint8_t>(subscribe_type::stealth);
+    std::copy(bytes.begin(), bytes.end(), topic.begin() + 1);
+    return topic;
+}
+
+static publisher::topic_set tx_topics(transaction_analysis::ptr analysis)
+{
+    publisher::topic_set topics;
+
+    for (const auto& address: analysis->output_addresses)
+        topics.insert(address_topic(address));
+
+    for (const auto prefix: analysis->stealth_prefixes)
+        topics.insert(stealth_topic(prefix));
+
+    // Transactions without a recognized output are sent with an empty
+    // topic, so they are only received by unfiltered subscribers.
+    if (topics.empty())
+        topics.insert(data_chunk());
+
+    return topics;
+}
+
+void publisher::send_block(uint32_t height, const chain::block& block,
+    const transaction_analysis::list& analyses)
+{
+    if (idle(socket_block_, block_feed_))
+        return;
+
+    if (settings_.publisher_compact_blocks)
+    {
+        send_compact_block(height, block, analyses);
+        return;
+    }
+
     // Serialize the height.
     data_chunk raw_height = to_chunk(to_little_endian(height));
     BITCOIN_ASSERT(raw_height.size() == sizeof(uint32_t));
@@ -87,34 +219,478 @@ void publisher::send_block(uint32_t height, const chain::block& block)
     //   height   [4 bytes]
     //   header   [80 bytes]
     //   ... txs ...
-    czmqpp::message message;
-    message.append(raw_height);
-    message.append(raw_block_header);
+    data_stack payload;
+    payload.reserve(2 + analyses.size());
+    payload.push_back(raw_height);
+    payload.push_back(raw_block_header);
 
     // Clients should be buffering their unconfirmed txs
     // and only be requesting those they don't have.
-    for (const auto& tx: block.transactions)
-        append_hash(message, tx.hash());
+    for (const auto& analysis: analyses)
+        payload.push_back(to_frame(analysis->hash));
 
     // Finished. Send message.
-    if (!message.send(socket_block_))
+    if (!publish(socket_block_, block_feed_, payload, topic_set()))
+        log::warning(LOG_PUBLISHER) << "Problem publishing block data.";
+}
+
+void publisher::send_raw_block(uint32_t height, const chain::block& block,
+    const transaction_analysis::list& analyses)
+{
+    if (idle(socket_raw_block_, raw_block_feed_))
+        return;
+
+    // The block database does not retain the raw block, so it is assembled
+    // once from the header and the transaction serializations already held
+    // by the analyses, rather than serialized again per subscriber.
+    const auto raw_header = block.header.to_data(false);
+    BITCOIN_ASSERT(raw_header.size() == 80);
+
+    size_t size = raw_header.size() + variable_uint_size(analyses.size());
+    for (const auto& analysis: analyses)
+        size += analysis->data.size();
+
+    data_chunk raw_block(size);
+    auto serial = make_serializer(raw_block.begin());
+    serial.write_data(raw_header);
+    serial.write_variable_uint_little_endian(analyses.size());
+    for (const auto& analysis: analyses)
+        serial.write_data(analysis->data);
+
+    BITCOIN_ASSERT(serial.iterator() == raw_block.end());
+
+    // The hash is in display (big endian) order, as waitblock.py expects.
+    const auto hash = block.header.hash();
+    const data_chunk raw_hash(hash.rbegin(), hash.rend());
+
+    // Construct the message.
+    //   height   [4 bytes]
+    //   hash     [32 bytes]
+    //   block    [variable]
+    const data_stack payload
+    {
+        to_chunk(to_little_endian(height)),
+        raw_hash,
+        raw_block
+    };
+
+    if (!publish(socket_raw_block_, raw_block_feed_, payload, topic_set()))
+        log::warning(LOG_PUBLISHER) << "Problem publishing raw block data.";
+}
+
+void publisher::send_disconnect(uint32_t height, const chain::block& block,
+    const transaction_analysis::list& analyses)
+{
+    static const std::string command = "disconnect";
+
+    if (idle(socket_block_, block_feed_))
+        return;
+
+    // Construct the message.
+    //   command  ["disconnect"]
+    //   height   [4 bytes]
+    //   hash     [32 bytes]
+    //   ... txs ...
+    data_stack payload;
+    payload.reserve(3 + analyses.size());
+    payload.push_back(data_chunk(command.begin(), command.end()));
+    payload.push_back(to_chunk(to_little_endian(height)));
+    payload.push_back(to_frame(block.header.hash()));
+
+    // The height is that of the block before it was disconnected.
+    for (const auto& analysis: analyses)
+        payload.push_back(to_frame(analysis->hash));
+
+    if (!publish(socket_block_, block_feed_, payload, topic_set()))
+        log::warning(LOG_PUBLISHER) << "Problem publishing block disconnect.";
+}
+
+void publisher::send_tx(const chain::transaction&,
+    transaction_analysis::ptr analysis)
+{
+    if (idle(socket_tx_, tx_feed_))
+        return;
+
+    // Construct the message.
+    //   topic    [type:1 + hash:20 | type:1 + prefix:4 | empty] (optional)
+    //   tx       [variable]
+    const data_stack payload{ analysis->data };
+
+    if (settings_.publisher_topics)
+    {
+        // Each distinct subscribed topic is sent once, ordered for
+        // determinism. Unsubscribed topics would be dropped by zeromq.
+        const auto topics = subscribed(tx_feed_, tx_topics(analysis));
+        const auto raw_sequence = record(tx_feed_, payload);
+
+        if (topics.empty())
+            return;
+
+        if (!send(socket_tx_, raw_sequence, payload, topics))
+        {
+            log::warning(LOG_PUBLISHER) << "Problem publishing tx data.";
+            return;
+        }
+    }
+    else if (!publish(socket_tx_, tx_feed_, payload, topic_set()))
     {
+        log::warning(LOG_PUBLISHER) << "Problem publishing tx data.";
+        return;
+    }
+
+    // Only transactions a subscriber may have received are short ids.
+    if (settings_.publisher_compact_blocks &&
+        !tx_feed_.subscriptions.empty())
+        set_published(analysis->hash);
+}
+
+void publisher::set_published(const hash_digest& tx_hash)
+{
+    if (!published_.insert(tx_hash).second)
+        return;
+
+    published_order_.push_back(tx_hash);
+
+    // Bound memory for transactions that never confirm.
+    while (published_order_.size() >
+        settings_.publisher_compact_published_capacity)
+    {
+        published_.erase(published_order_.front());
+        published_order_.pop_front();
+    }
+}
+
+static uint64_t random_nonce()
+{
+    static std::random_device device;
+    static std::mt19937_64 engine(device());
+    return engine();
+}
+
+void publisher::send_compact_block(uint32_t height, const chain::block& block,
+    const transaction_analysis::list& analyses)
+{
+    const auto raw_height = to_chunk(to_little_endian(height));
+    const auto raw_block_header = block.header.to_data(false);
+    BITCOIN_ASSERT(raw_block_header.size() == 80);
+
+    // A new nonce per block prevents collisions from being engineered.
+    const auto nonce = random_nonce();
+    const auto key = short_id_key(raw_block_header, nonce);
+
+    // Construct the message.
+    //   height     [4 bytes]
+    //   header     [80 bytes]
+    //   nonce      [8 bytes]
+    //   short ids  [6 bytes * unsent tx count]
+    //   ... prefilled txs [index:4 + tx] ...
+    compact_block compact{ block.header.hash(), analyses, {} };
+    data_chunk short_ids;
+    data_stack prefilled;
+
+    for (size_t index = 0; index < analyses.size(); ++index)
+    {
+        const auto& analysis = analyses[index];
+        const auto published = published_.erase(analysis->hash) != 0;
+        const auto id = short_id(key, analysis->hash);
+
+        // The coinbase is never published and is always prefilled, as is
+        // a transaction whose short id collides with an earlier one.
+        if (index == 0 || !published ||
+            !compact.indexes.emplace(id, index).second)
+        {
+            BITCOIN_ASSERT(index <= max_uint32);
+            auto frame = to_chunk(to_little_endian(
+                static_cast<uint32_t>(index)));
+            extend_data(frame, analysis->data);
+            prefilled.push_back(frame);
+            continue;
+        }
+
+        const auto raw_id = to_little_endian(id);
+        short_ids.insert(short_ids.end(), raw_id.begin(),
+            raw_id.begin() + short_id_size);
+    }
+
+    data_stack payload;
+    payload.reserve(4 + prefilled.size());
+    payload.push_back(raw_height);
+    payload.push_back(raw_block_header);
+    payload.push_back(to_chunk(to_little_endian(nonce)));
+    payload.push_back(short_ids);
+    payload.insert(payload.end(), prefilled.begin(), prefilled.end());
+
+    // Retain for missing transaction queries before subscribers can ask.
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        compact_blocks_.push_back(std::move(compact));
+        if (compact_blocks_.size() > compact_block_history)
+            compact_blocks_.pop_front();
+    }
+
+    if (!publish(socket_block_, block_feed_, payload, topic_set()))
         log::warning(LOG_PUBLISHER) << "Problem publishing block data.";
+}
+
+// Subscriptions are collected before each message, as only this thread
+// reads the socket. With XPUB_VERBOSE off zeromq passes on only the first
+// subscription and the last unsubscription of each topic.
+void publisher::update_subscriptions(czmqpp::socket& socket, feed& target)
+{
+    while (true)
+    {
+        czmqpp::message message;
+        if (!message.receive(socket))
+            break;
+
+        const auto& parts = message.parts();
+        if (parts.size() != 1 || parts.front().empty())
+            continue;
+
+        const auto& frame = parts.front();
+        const data_chunk topic(frame.begin() + 1, frame.end());
+
+        if (frame.front() == xpub_subscribe)
+        {
+            // The empty topic is a prefix of each topic copy of a tx.
+            if (topic.empty() && &target == &tx_feed_ &&
+                settings_.publisher_topics)
+                log::debug(LOG_PUBLISHER)
+                    << "Subscriber to all tx topics receives a copy per "
+                    << "topic, dedupe on sequence.";
+
+            target.subscriptions.insert(topic);
+        }
+        else if (frame.front() == xpub_unsubscribe)
+            target.subscriptions.erase(topic);
+    }
+}
+
+// True if a message on the feed need be neither sent nor built. It must
+// still be built for replay if sequencing, as clients recover by replay.
+bool publisher::idle(czmqpp::socket& socket, feed& target)
+{
+    update_subscriptions(socket, target);
+    return target.subscriptions.empty() && !settings_.publisher_sequence;
+}
+
+// The topics which match at least one subscription, where a subscription
+// matches any topic of which it is a prefix.
+publisher::topic_set publisher::subscribed(const feed& target,
+    const topic_set& topics) const
+{
+    topic_set result;
+    const auto& subscriptions = target.subscriptions;
+
+    for (const auto& topic: topics)
+    {
+        for (size_t size = 0; size <= topic.size(); ++size)
+        {
+            const data_chunk prefix(topic.begin(), topic.begin() + size);
+            if (subscriptions.find(prefix) != subscriptions.end())
+            {
+                result.insert(topic);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool publisher::publish(czmqpp::socket& socket, feed& target,
+    const data_stack& payload, const topic_set& topics)
+{
+    const auto raw_sequence = record(target, payload);
+
+    // Retained for replay but not sent, nobody would receive it.
+    if (target.subscriptions.empty())
+        return true;
+
+    return send(socket, raw_sequence, payload, topics);
+}
+
+// Numbers the message and retains it for replay, returns the sequence frame.
+data_chunk publisher::record(feed& target, const data_stack& payload)
+{
+    const auto sequence = ++target.sequence;
+
+    if (settings_.publisher_sequence)
+        target.replay.store(sequence, payload);
+
+    return to_chunk(to_little_endian(sequence));
+}
+
+// Sends the payload once per topic, or once untagged if there are none.
+// All copies share a sequence number, and only the payload is replayable.
+bool publisher::send(czmqpp::socket& socket, const data_chunk& raw_sequence,
+    const data_stack& payload, const topic_set& topics)
+{
+    const auto sequenced = settings_.publisher_sequence;
+
+    const auto send_one = [&](const data_chunk* topic) -> bool
+    {
+        czmqpp::message message;
+
+        if (topic != nullptr)
+            message.append(*topic);
+
+        if (sequenced)
+            message.append(raw_sequence);
+
+        for (const auto& frame: payload)
+            message.append(frame);
+
+        return message.send(socket);
+    };
+
+    if (topics.empty())
+        return send_one(nullptr);
+
+    for (const auto& topic: topics)
+        if (!send_one(&topic))
+            return false;
+
+    return true;
+}
+
+// Query service (worker thread).
+// ----------------------------------------------------------------------------
+
+void publisher::replay(const incoming_message& request,
+    queue_send_callback queue_send)
+{
+    const auto& data = request.data();
+
+    // [ feed:1 ][ from_sequence:8 ][ count:4 ]
+    if (data.size() != 1 + 8 + 4)
+    {
+        log::error(LOG_SERVICE)
+            << "Incorrect data size for server.replay";
         return;
     }
+
+    auto deserial = make_deserializer(data.begin(), data.end());
+    const auto feed_type = deserial.read_byte();
+    const auto from_sequence = deserial.read_8_bytes_little_endian();
+    const auto count = deserial.read_4_bytes_little_endian();
+
+    code ec;
+    replay_buffer::list entries;
+
+    if (!settings_.publisher_sequence)
+        ec = error::not_found;
+    else if (feed_type == publisher::block_feed)
+        entries = block_feed_.replay.fetch(from_sequence, count);
+    else if (feed_type == publisher::transaction_feed)
+        entries = tx_feed_.replay.fetch(from_sequence, count);
+    else if (feed_type == publisher::raw_block_feed)
+        entries = raw_block_feed_.replay.fetch(from_sequence, count);
+    else
+        ec = error::bad_stream;
+
+    // [ sequence:8 ][ frame_count:4 ] ([ frame_size:4 ][ frame ])...
+    size_t size = 4;
+    for (const auto& entry: entries)
+    {
+        size += 8 + 4;
+        for (const auto& frame: entry.frames)
+            size += 4 + frame.size();
+    }
+
+    data_chunk result(size);
+    auto serial = make_serializer(result.begin());
+    write_error_code(serial, ec);
+    BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
+
+    for (const auto& entry: entries)
+    {
+        BITCOIN_ASSERT(entry.frames.size() <= max_uint32);
+        const auto frame_count = static_cast<uint32_t>(entry.frames.size());
+        serial.write_8_bytes_little_endian(entry.sequence);
+        serial.write_4_bytes_little_endian(frame_count);
+
+        for (const auto& frame: entry.frames)
+        {
+            BITCOIN_ASSERT(frame.size() <= max_uint32);
+            const auto frame_size = static_cast<uint32_t>(frame.size());
+            serial.write_4_bytes_little_endian(frame_size);
+            serial.write_data(frame);
+        }
+    }
+
+    BITCOIN_ASSERT(serial.iterator() == result.end());
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
 }
 
-void publisher::send_tx(const chain::transaction& tx)
+void publisher::fetch_compact_transactions(const incoming_message& request,
+    queue_send_callback queue_send)
 {
-    data_chunk raw_tx = tx.to_data();
-    czmqpp::message message;
-    message.append(raw_tx);
+    const auto& data = request.data();
 
-    if (!message.send(socket_tx_))
+    // [ block_hash:32 ] ([ short_id:6 ])...
+    if (data.size() < hash_size ||
+        (data.size() - hash_size) % short_id_size != 0)
     {
-        log::warning(LOG_PUBLISHER) << "Problem publishing tx data.";
+        log::error(LOG_SERVICE)
+            << "Incorrect data size for server.fetch_compact_transactions";
         return;
     }
+
+    auto deserial = make_deserializer(data.begin(), data.end());
+    const auto block_hash = deserial.read_hash();
+    const auto count = (data.size() - hash_size) / short_id_size;
+
+    code ec;
+    transaction_analysis::list found;
+    found.reserve(count);
+
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+
+        auto block = compact_blocks_.begin();
+        for (; block != compact_blocks_.end(); ++block)
+            if (block->hash == block_hash)
+                break;
+
+        if (block == compact_blocks_.end())
+            ec = error::not_found;
+
+        for (size_t item = 0; !ec && item < count; ++item)
+        {
+            byte_array<8> raw_id{ { 0 } };
+            const auto id_data = deserial.read_data(short_id_size);
+            std::copy(id_data.begin(), id_data.end(), raw_id.begin());
+            const auto id = from_little_endian_unsafe<uint64_t>(
+                raw_id.begin());
+
+            const auto index = block->indexes.find(id);
+            if (index == block->indexes.end())
+                ec = error::not_found;
+            else
+                found.push_back(block->analyses[index->second]);
+        }
+    }
+
+    if (ec)
+        found.clear();
+
+    size_t size = 4;
+    for (const auto& analysis: found)
+        size += analysis->data.size();
+
+    data_chunk result(size);
+    auto serial = make_serializer(result.begin());
+    write_error_code(serial, ec);
+    BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
+
+    for (const auto& analysis: found)
+        serial.write_data(analysis->data);
+
+    BITCOIN_ASSERT(serial.iterator() == result.end());
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
 }
 
 } // namespace server
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/replay_buffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+replay_buffer::replay_buffer(size_t capacity)
+  : capacity_(capacity)
+{
+}
+
+void replay_buffer::store(uint64_t sequence, const data_stack& frames)
+{
+    if (capacity_ == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    BITCOIN_ASSERT(entries_.empty() || entries_.back().sequence < sequence);
+
+    if (entries_.size() == capacity_)
+        entries_.pop_front();
+
+    entries_.push_back({ sequence, frames });
+}
+
+replay_buffer::list replay_buffer::fetch(uint64_t from_sequence,
+    size_t count) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Sequences are increasing but may not be contiguous.
+    const auto start = std::lower_bound(entries_.begin(), entries_.end(),
+        from_sequence, [](const entry& item, uint64_t sequence)
+        {
+            return item.sequence < sequence;
+        });
+
+    const auto available = static_cast<size_t>(entries_.end() - start);
+    const auto stop = start + std::min(count, available);
+    return list(start, stop);
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/reply_tracker.hpp>
+
+#include <atomic>
+#include <memory>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/service/util.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+reply_tracker::reply_tracker()
+  : replied_(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+queue_send_callback reply_tracker::wrap(queue_send_callback reply) const
+{
+    const auto replied = replied_;
+    return [replied, reply](const outgoing_message& message)
+    {
+        replied->store(true);
+        reply(message);
+    };
+}
+
+// A callback released on another thread just after replying may be seen
+// as released but not replied, which only frees the class early.
+bool reply_tracker::abandoned() const
+{
+    return replied_.use_count() == 1 && !replied_->load();
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/request_log.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/message.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+static const std::string log_magic = "BSRL";
+static constexpr uint8_t log_version = 1;
+
+// Requests larger than this are taken as a corrupt log.
+static constexpr uint64_t maximum_field = 1024 * 1024 * 32;
+
+static void write_variable(std::ostream& stream, uint64_t value)
+{
+    data_chunk raw(variable_uint_size(value));
+    auto serial = make_serializer(raw.begin());
+    serial.write_variable_uint_little_endian(value);
+    stream.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+}
+
+static bool read_variable(std::istream& stream, uint64_t& value)
+{
+    const auto prefix = stream.get();
+    if (prefix == std::char_traits<char>::eof())
+        return false;
+
+    size_t size;
+    switch (prefix)
+    {
+        case 0xfd: size = 2; break;
+        case 0xfe: size = 4; break;
+        case 0xff: size = 8; break;
+        default:
+            value = static_cast<uint64_t>(prefix);
+            return true;
+    }
+
+    uint8_t raw[8];
+    if (!stream.read(reinterpret_cast<char*>(raw), size))
+        return false;
+
+    value = 0;
+    for (size_t byte = size; byte > 0; --byte)
+        value = (value << 8) | raw[byte - 1];
+
+    return true;
+}
+
+request_recorder::request_recorder(const boost::filesystem::path& file)
+  : path_(file), recorded_(0)
+{
+}
+
+request_recorder::~request_recorder()
+{
+    stop();
+}
+
+bool request_recorder::start()
+{
+    if (path_.empty())
+        return true;
+
+    file_.open(path_.string(), std::ios::out | std::ios::binary |
+        std::ios::trunc);
+    if (!file_)
+    {
+        log::error(LOG_SERVICE)
+            << "Failed to open request log " << path_;
+        return false;
+    }
+
+    file_.write(log_magic.data(), log_magic.size());
+    file_.put(static_cast<char>(log_version));
+    previous_ = clock::now();
+
+    log::info(LOG_SERVICE)
+        << "Recording requests to " << path_;
+    return true;
+}
+
+void request_recorder::stop()
+{
+    if (!file_.is_open())
+        return;
+
+    file_.close();
+    log::info(LOG_SERVICE)
+        << "Recorded " << recorded_ << " requests to " << path_;
+}
+
+void request_recorder::record(const incoming_message& request)
+{
+    if (!file_.is_open())
+        return;
+
+    using namespace std::chrono;
+    const auto now = clock::now();
+    const auto delta = duration_cast<microseconds>(now - previous_).count();
+    previous_ = now;
+
+    const auto& command = request.command();
+    const auto& data = request.data();
+    write_variable(file_, static_cast<uint64_t>(delta));
+    write_variable(file_, command.size());
+    file_.write(command.data(), command.size());
+    write_variable(file_, data.size());
+    file_.write(reinterpret_cast<const char*>(data.data()), data.size());
+    ++recorded_;
+}
+
+void request_recorder::flush()
+{
+    if (file_.is_open())
+        file_.flush();
+}
+
+uint64_t request_recorder::recorded() const
+{
+    return recorded_;
+}
+
+request_log_reader::request_log_reader(const boost::filesystem::path& file)
+  : file_(file.string(), std::ios::in | std::ios::binary),
+    elapsed_(0),
+    valid_(false)
+{
+    std::string magic(log_magic.size(), '\0');
+    if (!file_.read(&magic[0], magic.size()) || magic != log_magic)
+        return;
+
+    valid_ = file_.get() == log_version;
+}
+
+bool request_log_reader::valid() const
+{
+    return valid_;
+}
+
+bool request_log_reader::read(recorded_request& out)
+{
+    if (!valid_)
+        return false;
+
+    uint64_t delta;
+    uint64_t command_size;
+    if (!read_variable(file_, delta) ||
+        !read_variable(file_, command_size) || command_size > maximum_field)
+        return false;
+
+    std::string command(static_cast<size_t>(command_size), '\0');
+    if (!file_.read(&command[0], command.size()))
+        return false;
+
+    uint64_t data_size;
+    if (!read_variable(file_, data_size) || data_size > maximum_field)
+        return false;
+
+    data_chunk data(static_cast<size_t>(data_size));
+    if (!file_.read(reinterpret_cast<char*>(data.data()), data.size()))
+        return false;
+
+    elapsed_ += delta;
+    out = { elapsed_, std::move(command), std::move(data) };
+    return true;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,239 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/request_logger.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/configuration.hpp>
+#include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/message.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// The writer sleeps for this period when the buffer is empty.
+static const auto idle_period = std::chrono::milliseconds(10);
+
+// The history request is version (1) + address hash (20) + height (4).
+static constexpr size_t history_request_size = 1 + short_hash_size + 4;
+
+static bool is_history(const std::string& command)
+{
+    return command == "blockchain.fetch_history" ||
+        command == "address.fetch_history" ||
+        command == "address.fetch_history2";
+}
+
+request_logger::request_logger(const settings& settings)
+  : sample_interval_(settings.log_requests ?
+        std::max(settings.log_request_sample_interval, 1u) : 0),
+    buffer_(std::max(settings.log_request_capacity, 1u)),
+    started_(false),
+    stopped_(false),
+    dropped_(0)
+{
+}
+
+request_logger::~request_logger()
+{
+    stop();
+}
+
+bool request_logger::start()
+{
+    if (sample_interval_ == 0 || started_)
+        return true;
+
+    stopped_ = false;
+    thread_ = std::thread(&request_logger::run, this);
+    started_ = true;
+    return true;
+}
+
+void request_logger::stop()
+{
+    if (!started_)
+        return;
+
+    // The writer drains the buffer before it exits.
+    stopped_ = true;
+    thread_.join();
+    started_ = false;
+}
+
+bool request_logger::sampled(const incoming_message& request) const
+{
+    return started_.load(std::memory_order_relaxed) &&
+        request.id() % sample_interval_ == 0;
+}
+
+void request_logger::log(event type, const std::string& command,
+    const incoming_message& request)
+{
+    const auto& origin = request.origin();
+    const auto& data = request.data();
+
+    record item;
+    item.type = type;
+    item.id = request.id();
+    item.value = 0;
+    item.time = clock::now();
+    item.command = &command;
+    item.origin_size = static_cast<uint8_t>(
+        std::min(origin.size(), item.origin.size()));
+    item.data_size = static_cast<uint32_t>(data.size());
+    std::copy_n(origin.begin(), item.origin_size, item.origin.begin());
+    std::copy_n(data.begin(), std::min(data.size(), item.data.size()),
+        item.data.begin());
+
+    push(item);
+}
+
+void request_logger::log(const std::string& command, const data_chunk& origin,
+    const outgoing_message& reply)
+{
+    const auto& data = reply.data();
+
+    record item;
+    item.type = event::reply;
+    item.id = reply.id();
+    item.time = clock::now();
+    item.command = &command;
+    item.origin_size = static_cast<uint8_t>(
+        std::min(origin.size(), item.origin.size()));
+    item.data_size = static_cast<uint32_t>(data.size());
+    std::copy_n(origin.begin(), item.origin_size, item.origin.begin());
+
+    // Replies lead with a little endian error code.
+    item.value = data.size() < sizeof(uint32_t) ? 0 :
+        from_little_endian_unsafe<uint32_t>(data.begin());
+
+    push(item);
+}
+
+uint64_t request_logger::dropped() const
+{
+    return dropped_;
+}
+
+void request_logger::push(record& item)
+{
+    if (!buffer_.push(std::move(item)))
+        ++dropped_;
+}
+
+void request_logger::run()
+{
+    uint64_t reported = 0;
+    record item;
+
+    while (true)
+    {
+        // Read the flag first so that nothing pushed before it is missed.
+        const auto stopping = stopped_.load();
+        while (buffer_.pop(item))
+            write(item);
+
+        const auto dropped = dropped_.load();
+        if (dropped != reported)
+        {
+            log::warning(LOG_REQUEST)
+                << "Request log dropped " << dropped - reported
+                << " records.";
+            reported = dropped;
+        }
+
+        if (stopping)
+            return;
+
+        std::this_thread::sleep_for(idle_period);
+    }
+}
+
+void request_logger::write(const record& item) const
+{
+    const auto microseconds = std::chrono::duration_cast<
+        std::chrono::microseconds>(item.time.time_since_epoch()).count();
+
+    std::ostringstream text;
+    text << (microseconds / 1000000) << "." << std::setw(6)
+        << std::setfill('0') << (microseconds % 1000000) << " ";
+
+    switch (item.type)
+    {
+        case event::receive:
+            text << "Service request";
+            break;
+        case event::reply:
+            text << "Reply";
+            break;
+        case event::shed:
+            text << "Shed service request";
+            break;
+    }
+
+    const data_chunk origin(item.origin.begin(),
+        item.origin.begin() + item.origin_size);
+    text << " [" << *item.command << "] id " << item.id << " client "
+        << encode_base16(origin);
+
+    if (item.type == event::reply)
+    {
+        text << " ec=" << item.value << " bytes=" << item.data_size;
+    }
+    else if (is_history(*item.command) &&
+        item.data_size == history_request_size)
+    {
+        auto deserial = make_deserializer(item.data.begin(),
+            item.data.begin() + history_request_size);
+        const auto version = deserial.read_byte();
+        const auto hash = deserial.read_short_hash();
+        const auto from_height = deserial.read_4_bytes_little_endian();
+        text << " " << wallet::payment_address(hash, version).encoded()
+            << " from_height=" << from_height;
+    }
+    else if (item.data_size == hash_size)
+    {
+        hash_digest hash;
+        std::copy_n(item.data.begin(), hash_size, hash.begin());
+        text << " " << encode_hash(hash);
+    }
+    else
+    {
+        const auto shown = std::min<size_t>(item.data_size,
+            item.data.size());
+        const data_chunk data(item.data.begin(), item.data.begin() + shown);
+        text << " data=" << encode_base16(data)
+            << (shown < item.data_size ? "..." : "")
+            << " bytes=" << item.data_size;
+    }
+
+    log::debug(LOG_REQUEST) << text.str();
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,367 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/request_scheduler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// CoDel resumes near its last drop rate if the delay returns within this
+// many intervals of leaving the dropping state.
+static constexpr uint32_t codel_memory_intervals = 8;
+
+// The cost of each command, unlisted commands are normal.
+static const std::unordered_map<std::string, request_class> costs
+{
+    { "blockchain.fetch_last_height", request_class::cheap },
+    { "blockchain.fetch_block_header", request_class::cheap },
+    { "blockchain.fetch_block_height", request_class::cheap },
+    { "blockchain.fetch_transaction_index", request_class::cheap },
+    { "protocol.total_connections", request_class::cheap },
+    { "transaction_pool.fetch_transaction", request_class::cheap },
+    { "address.renew", request_class::cheap },
+    { "server.replay", request_class::cheap },
+    { "server.stats", request_class::cheap },
+    { "address.fetch_history", request_class::expensive },
+    { "address.fetch_history2", request_class::expensive },
+    { "blockchain.fetch_block_headers", request_class::expensive },
+    { "blockchain.fetch_history", request_class::expensive },
+    { "blockchain.fetch_transactions", request_class::expensive },
+    { "blockchain.fetch_transaction_with_prevouts",
+        request_class::expensive },
+    { "blockchain.fetch_stealth", request_class::expensive }
+};
+
+// Idle rate limited clients are forgotten at most this often.
+static const auto prune_interval = std::chrono::seconds(1);
+
+static size_t index(request_class type)
+{
+    return static_cast<size_t>(type);
+}
+
+request_scheduler::request_scheduler(const settings& settings,
+    time_source now)
+  : now_(now),
+    target_(std::chrono::milliseconds(
+        settings.query_delay_target_milliseconds)),
+    interval_(std::chrono::milliseconds(
+        settings.query_delay_interval_milliseconds)),
+    rate_(settings.query_rate_limit),
+    burst_(std::max(settings.query_rate_burst, 1u)),
+    weights_(parse_weights(settings.query_client_weights)),
+    limited_(0)
+{
+    lanes_[index(request_class::normal)].limit =
+        settings.query_normal_concurrency;
+    lanes_[index(request_class::expensive)].limit =
+        settings.query_expensive_concurrency;
+}
+
+// Each weight is configured as the client identity text and its weight,
+// separated by the last colon.
+request_scheduler::weight_map request_scheduler::parse_weights(
+    const std::vector<std::string>& weights)
+{
+    weight_map parsed;
+    for (const auto& item: weights)
+    {
+        const auto separator = item.rfind(':');
+        const auto weight = separator == std::string::npos ? 0 :
+            std::strtoul(item.c_str() + separator + 1, nullptr, 10);
+
+        if (separator == 0 || weight == 0 || weight > max_uint32)
+        {
+            log::warning(LOG_SERVICE)
+                << "Ignored invalid client weight [" << item << "]";
+            continue;
+        }
+
+        const auto identity = item.substr(0, separator);
+        parsed[data_chunk(identity.begin(), identity.end())] =
+            static_cast<uint32_t>(weight);
+    }
+
+    return parsed;
+}
+
+request_class request_scheduler::classify(const std::string& command)
+{
+    const auto it = costs.find(command);
+    return it == costs.end() ? request_class::normal : it->second;
+}
+
+std::string request_scheduler::to_string(request_class type)
+{
+    switch (type)
+    {
+        case request_class::cheap:
+            return "cheap";
+        case request_class::expensive:
+            return "expensive";
+        case request_class::normal:
+        default:
+            return "normal";
+    }
+}
+
+void request_scheduler::submit(request_class type, const data_chunk& origin,
+    action run, action shed)
+{
+    const auto now = now_();
+    if (!take_token(origin, now))
+    {
+        ++limited_;
+        shed();
+        return;
+    }
+
+    // Run without queueing if nothing of the class is deferred.
+    auto& queue = lanes_[index(type)];
+    if (queue.deferred == 0 &&
+        (queue.limit == 0 || queue.running < queue.limit))
+    {
+        ++queue.running;
+        run();
+        return;
+    }
+
+    // A client is in the round for as long as it has a flow.
+    const auto inserted = queue.flows.insert({ origin, flow() });
+    auto& client = inserted.first->second;
+    if (inserted.second)
+    {
+        client.weight = weight(origin);
+        queue.active.push_back(origin);
+    }
+
+    client.queue.push_back({ now, run, shed });
+    ++queue.deferred;
+    drain(queue, now);
+}
+
+void request_scheduler::release(request_class type)
+{
+    auto& queue = lanes_[index(type)];
+    BITCOIN_ASSERT(queue.running > 0);
+    if (queue.running > 0)
+        --queue.running;
+}
+
+void request_scheduler::update()
+{
+    const auto now = now_();
+    for (auto& queue: lanes_)
+        drain(queue, now);
+
+    if (now >= next_prune_)
+    {
+        prune_buckets(now);
+        next_prune_ = now + prune_interval;
+    }
+}
+
+uint64_t request_scheduler::running(request_class type) const
+{
+    return lanes_[index(type)].running;
+}
+
+uint64_t request_scheduler::deferred(request_class type) const
+{
+    return lanes_[index(type)].deferred;
+}
+
+uint64_t request_scheduler::shed(request_class type) const
+{
+    return lanes_[index(type)].shed;
+}
+
+uint64_t request_scheduler::limited() const
+{
+    return limited_;
+}
+
+uint32_t request_scheduler::weight(const data_chunk& origin) const
+{
+    const auto it = weights_.find(origin);
+    return it == weights_.end() ? 1 : it->second;
+}
+
+// A token bucket per client, refilled at the rate limit and holding up to
+// the burst, both scaled by the weight of the client.
+bool request_scheduler::take_token(const data_chunk& origin,
+    clock::time_point now)
+{
+    if (rate_ == 0)
+        return true;
+
+    const auto scale = static_cast<double>(weight(origin));
+    const auto capacity = burst_ * scale;
+    auto it = buckets_.find(origin);
+    if (it == buckets_.end())
+        it = buckets_.insert({ origin, { capacity, now } }).first;
+
+    auto& bucket = it->second;
+    const std::chrono::duration<double> elapsed = now - bucket.updated;
+    bucket.tokens = std::min(capacity,
+        bucket.tokens + elapsed.count() * rate_ * scale);
+    bucket.updated = now;
+
+    if (bucket.tokens < 1.0)
+        return false;
+
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+// A bucket that would be full by now is the same as no bucket.
+void request_scheduler::prune_buckets(clock::time_point now)
+{
+    for (auto it = buckets_.begin(); it != buckets_.end();)
+    {
+        const auto scale = static_cast<double>(weight(it->first));
+        const std::chrono::duration<double> elapsed = now - it->second.updated;
+        const auto tokens = it->second.tokens + elapsed.count() * rate_ * scale;
+
+        if (tokens >= burst_ * scale)
+            it = buckets_.erase(it);
+        else
+            ++it;
+    }
+}
+
+// Shed from the head of each client queue while CoDel drops.
+void request_scheduler::shed_delayed(lane& queue, clock::time_point now)
+{
+    for (auto& item: queue.flows)
+    {
+        auto& client = item.second;
+        while (!client.queue.empty() && should_shed(client, now,
+            now - client.queue.front().enqueued))
+        {
+            const auto shed = std::move(client.queue.front().shed);
+            client.queue.pop_front();
+            --queue.deferred;
+            ++queue.shed;
+            shed();
+        }
+    }
+}
+
+// Run deferred queries in deficit round robin order of their clients while
+// the class is below its concurrency, a limit of zero is unlimited.
+void request_scheduler::drain(lane& queue, clock::time_point now)
+{
+    if (queue.deferred > 0)
+        shed_delayed(queue, now);
+
+    while (!queue.active.empty() &&
+        (queue.limit == 0 || queue.running < queue.limit))
+    {
+        const auto it = queue.flows.find(queue.active.front());
+        BITCOIN_ASSERT(it != queue.flows.end());
+        auto& client = it->second;
+
+        // An emptied client leaves the round, and with it its CoDel state.
+        if (client.queue.empty())
+        {
+            queue.flows.erase(it);
+            queue.active.pop_front();
+            continue;
+        }
+
+        // A client with no deficit is granted its weight for the next round.
+        if (client.deficit == 0)
+        {
+            client.deficit = client.weight;
+            queue.active.push_back(queue.active.front());
+            queue.active.pop_front();
+            continue;
+        }
+
+        const auto run = std::move(client.queue.front().run);
+        client.queue.pop_front();
+        --client.deficit;
+        --queue.deferred;
+        ++queue.running;
+        run();
+    }
+}
+
+bool request_scheduler::should_shed(flow& client, clock::time_point now,
+    clock::duration delay)
+{
+    if (delay < target_)
+    {
+        client.first_above = clock::time_point();
+        client.dropping = false;
+        return false;
+    }
+
+    // The delay must persist above target for an interval before shedding.
+    if (client.first_above == clock::time_point())
+    {
+        client.first_above = now + interval_;
+        return false;
+    }
+
+    if (now < client.first_above)
+        return false;
+
+    if (!client.dropping)
+    {
+        const auto recent = now - client.drop_next <
+            interval_ * codel_memory_intervals;
+        client.count = recent && client.count > 2 ? client.count - 2 : 1;
+        client.drop_next = control_law(now, client.count);
+        client.dropping = true;
+        return true;
+    }
+
+    if (now < client.drop_next)
+        return false;
+
+    ++client.count;
+    client.drop_next = control_law(client.drop_next, client.count);
+    return true;
+}
+
+// The next drop time, sooner as drops accumulate without relieving delay.
+request_scheduler::clock::time_point request_scheduler::control_law(
+    clock::time_point time, uint32_t count) const
+{
+    const auto spacing = interval_ / std::sqrt(static_cast<double>(count));
+    return time + std::chrono::duration_cast<clock::duration>(spacing);
+}
+
+} // namespace server
+} // namespace libbitcoin
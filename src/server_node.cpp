@@ -19,6 +19,7 @@
  */
 #include <bitcoin/server/server_node.hpp>
 
+#include <algorithm>
 #include <future>
 #include <iostream>
 #include <boost/filesystem.hpp>
@@ -75,6 +76,8 @@ static const configuration default_configuration()
     defaults.server.heartbeat_endpoint = SERVER_HEARTBEAT_ENDPOINT;
     defaults.server.block_publish_endpoint = SERVER_BLOCK_PUBLISH_ENDPOINT;
     defaults.server.transaction_publish_endpoint = SERVER_TRANSACTION_PUBLISH_ENDPOINT;
+    defaults.server.raw_block_publish_endpoint = SERVER_RAW_BLOCK_PUBLISH_ENDPOINT;
+    defaults.server.stats_endpoint = SERVER_STATS_ENDPOINT;
     defaults.server.publisher_enabled = SERVER_PUBLISHER_ENABLED;
     defaults.server.queries_enabled = SERVER_QUERIES_ENABLED;
     defaults.server.log_requests = SERVER_LOG_REQUESTS;
@@ -85,6 +88,37 @@ static const configuration default_configuration()
     defaults.server.certificate_file = SERVER_CERTIFICATE_FILE;
     defaults.server.client_certificates_path = SERVER_CLIENT_CERTIFICATES_PATH;
     defaults.server.whitelists = SERVER_WHITELISTS;
+    defaults.server.outbound_queue_messages = SERVER_OUTBOUND_QUEUE_MESSAGES;
+    defaults.server.outbound_queue_bytes = SERVER_OUTBOUND_QUEUE_BYTES;
+    defaults.server.slow_client_timeout_seconds = SERVER_SLOW_CLIENT_TIMEOUT_SECONDS;
+    defaults.server.transaction_cache_capacity = SERVER_TRANSACTION_CACHE_CAPACITY;
+    defaults.server.notification_bus_capacity = SERVER_NOTIFICATION_BUS_CAPACITY;
+    defaults.server.publisher_topics = SERVER_PUBLISHER_TOPICS;
+    defaults.server.publisher_sequence = SERVER_PUBLISHER_SEQUENCE;
+    defaults.server.publisher_replay_capacity = SERVER_PUBLISHER_REPLAY_CAPACITY;
+    defaults.server.publisher_compact_blocks = SERVER_PUBLISHER_COMPACT_BLOCKS;
+    defaults.server.publisher_compact_published_capacity = SERVER_PUBLISHER_COMPACT_PUBLISHED_CAPACITY;
+    defaults.server.publisher_disconnects = SERVER_PUBLISHER_DISCONNECTS;
+    defaults.server.publisher_raw_blocks = SERVER_PUBLISHER_RAW_BLOCKS;
+    defaults.server.hot_address_capacity = SERVER_HOT_ADDRESS_CAPACITY;
+    defaults.server.negative_filter_addresses = SERVER_NEGATIVE_FILTER_ADDRESSES;
+    defaults.server.negative_filter_transactions = SERVER_NEGATIVE_FILTER_TRANSACTIONS;
+    defaults.server.negative_filter_spends = SERVER_NEGATIVE_FILTER_SPENDS;
+    defaults.server.negative_filter_false_positive_rate = SERVER_NEGATIVE_FILTER_FALSE_POSITIVE_RATE;
+    defaults.server.stats_enabled = SERVER_STATS_ENABLED;
+    defaults.server.trace_sample_interval = SERVER_TRACE_SAMPLE_INTERVAL;
+    defaults.server.trace_file = SERVER_TRACE_FILE;
+    defaults.server.record_file = SERVER_RECORD_FILE;
+    defaults.server.query_normal_concurrency = SERVER_QUERY_NORMAL_CONCURRENCY;
+    defaults.server.query_expensive_concurrency = SERVER_QUERY_EXPENSIVE_CONCURRENCY;
+    defaults.server.query_delay_target_milliseconds = SERVER_QUERY_DELAY_TARGET_MILLISECONDS;
+    defaults.server.query_delay_interval_milliseconds = SERVER_QUERY_DELAY_INTERVAL_MILLISECONDS;
+    defaults.server.query_rate_limit = SERVER_QUERY_RATE_LIMIT;
+    defaults.server.query_rate_burst = SERVER_QUERY_RATE_BURST;
+    defaults.server.query_client_weights = SERVER_QUERY_CLIENT_WEIGHTS;
+    defaults.server.log_request_sample_interval = SERVER_LOG_REQUEST_SAMPLE_INTERVAL;
+    defaults.server.log_request_capacity = SERVER_LOG_REQUEST_CAPACITY;
+    defaults.server.header_store_enabled = SERVER_HEADER_STORE_ENABLED;
     return defaults;
 };
 
@@ -94,18 +128,68 @@ server_node::server_node(const configuration& config)
   : full_node(config),
     configuration_(config),
     retry_start_timer_(memory_threads_.service()),
+    tx_cache_(config.server.transaction_cache_capacity),
+    notifications_(config.server.notification_bus_capacity),
+    hot_addresses_(config.server.hot_address_capacity),
+    filters_(config.server),
+    headers_(config.server),
     last_checkpoint_height_(config.last_checkpoint_height())
 {
+    add_gauges();
 }
 
-void server_node::subscribe_blocks(block_notify_callback notify_block)
+notification_bus& server_node::notifications()
 {
-    block_sunscriptions_.push_back(notify_block);
+    return notifications_;
 }
 
-void server_node::subscribe_transactions(transaction_notify_callback notify_tx)
+hot_address_cache& server_node::hot_addresses()
 {
-    tx_subscriptions_.push_back(notify_tx);
+    return hot_addresses_;
+}
+
+negative_filters& server_node::filters()
+{
+    return filters_;
+}
+
+header_store& server_node::headers()
+{
+    return headers_;
+}
+
+statistics& server_node::stats()
+{
+    return stats_;
+}
+
+void server_node::add_gauges()
+{
+    stats_.add_gauge("notification_bus_dropped",
+        [this]() { return notifications_.dropped(); });
+    stats_.add_gauge("notification_bus_lag",
+        [this]()
+        {
+            uint64_t lag = 0;
+            for (const auto& consumer: notifications_.status())
+                lag = std::max(lag, consumer.lag);
+
+            return lag;
+        });
+    stats_.add_gauge("transaction_cache_size",
+        [this]() { return tx_cache_.size(); });
+    stats_.add_gauge("transaction_cache_hits",
+        [this]() { return tx_cache_.hits(); });
+    stats_.add_gauge("transaction_cache_misses",
+        [this]() { return tx_cache_.misses(); });
+    stats_.add_gauge("hot_address_hits",
+        [this]() { return hot_addresses_.hits(); });
+    stats_.add_gauge("hot_address_misses",
+        [this]() { return hot_addresses_.misses(); });
+    stats_.add_gauge("negative_filter_answers",
+        [this]() { return filters_.negatives(); });
+    stats_.add_gauge("header_store_size",
+        [this]() { return headers_.size(); });
 }
 
 void server_node::handle_tx_validated(const code& ec, const transaction& tx,
@@ -116,30 +200,120 @@ void server_node::handle_tx_validated(const code& ec, const transaction& tx,
     if (ec == bc::error::service_stopped)
         return;
 
-    // Fire server protocol tx subscription notifications.
-    for (const auto notify: tx_subscriptions_)
-        notify(tx);
+    // Unconfirmed transactions are known to pool history queries.
+    if (!ec)
+        filters_.insert(tx, hash);
+
+    const auto notify = notifications_.subscribed();
+    if (!notify && hot_addresses_.empty())
+        return;
+
+    // The tx pool provides the hash, so the cache doesn't compute it.
+    const auto analysis = tx_cache_.get(tx, hash);
+
+    // Invalidated here rather than by a consumer, so that no query is
+    // answered from a history older than the pool.
+    hot_addresses_.invalidate(*analysis);
+
+    if (!notify)
+        return;
+
+    // Consumers share one copy, the caller's tx reference is transient.
+    notification item;
+    item.type = notification::kind::transaction;
+    item.height = 0;
+    item.tx = std::make_shared<const transaction>(tx);
+    item.analysis = analysis;
+
+    // Only a pointer is handed off, the consumers do the work.
+    notifications_.publish(std::move(item));
+}
+
+transaction_analysis::list server_node::analyze(const block& block)
+{
+    // Mostly cache hits, as transactions are usually pooled first.
+    data_chunk buffer;
+    transaction_analysis::list analyses;
+    analyses.reserve(block.transactions.size());
+    for (const auto& tx: block.transactions)
+        analyses.push_back(tx_cache_.get(tx, buffer));
+
+    return analyses;
 }
 
 void server_node::handle_new_blocks(const code& ec, uint64_t fork_point,
     const block_chain::list& new_blocks,
     const block_chain::list& replaced_blocks)
 {
-    handle_new_blocks(ec, fork_point, new_blocks, replaced_blocks);
+    full_node::handle_new_blocks(ec, fork_point, new_blocks, replaced_blocks);
 
     if (ec == bc::error::service_stopped)
         return;
 
-    if (fork_point < last_checkpoint_height_)
+    headers_.reorganize(fork_point, new_blocks);
+
+    const auto filter = filters_.enabled();
+    const auto notify = fork_point >= last_checkpoint_height_ &&
+        notifications_.subscribed();
+
+    if (!filter && !notify && hot_addresses_.empty())
         return;
 
-    // Fire server protocol block subscription notifications.
-    for (auto new_block: new_blocks)
+    const auto publish = [this, filter, notify](notification::kind type,
+        size_t height, notification::block_ptr block)
     {
-        const size_t height = ++fork_point;
-        for (const auto notify: block_sunscriptions_)
-            notify(height, *new_block);
-    }
+        BITCOIN_ASSERT(height <= max_uint32);
+        const auto connected = type == notification::kind::block;
+        if (!(filter && connected) && !notify && hot_addresses_.empty())
+            return;
+
+        auto analyses = analyze(*block);
+        const auto& transactions = block->transactions;
+
+        // Disconnected transactions are left in the filters, which only
+        // costs stale positives. The analysis hashes are not recomputed.
+        if (filter && connected)
+            for (size_t index = 0; index < analyses.size(); ++index)
+                filters_.insert(transactions[index], analyses[index]->hash);
+
+        for (const auto& analysis: analyses)
+            hot_addresses_.invalidate(*analysis);
+
+        if (!notify)
+            return;
+
+        notification item;
+        item.type = type;
+        item.height = static_cast<uint32_t>(height);
+        item.block = block;
+        item.analyses = std::move(analyses);
+
+        // Never waits, a consumer a full ring behind drops the overrun.
+        notifications_.publish(std::move(item));
+    };
+
+    // Replaced blocks are notified tip first, with their former heights,
+    // and before the blocks that replace them.
+    for (auto index = replaced_blocks.size(); index > 0; --index)
+        publish(notification::kind::disconnect, fork_point + index,
+            replaced_blocks[index - 1]);
+
+    for (auto new_block: new_blocks)
+        publish(notification::kind::block, ++fork_point, new_block);
+
+    // Use the block 10 minute window as a periodic trigger.
+    if (notify)
+        log_notification_status();
+}
+
+void server_node::log_notification_status()
+{
+    for (const auto& consumer: notifications_.status())
+        log::debug(LOG_SERVICE)
+            << "Notification consumer " << consumer.name << " lag "
+            << consumer.lag << " processed " << consumer.processed
+            << " in " << consumer.batches << " batches, dropped "
+            << consumer.dropped;
 }
 
 void server_node::fullnode_fetch_history(server_node& node,
@@ -151,10 +325,35 @@ void server_node::fullnode_fetch_history(server_node& node,
     if (!unwrap_fetch_history_args(address, from_height, request))
         return;
 
-    const auto handler = 
+    const auto& hash = address.hash();
+    if (!node.filters().may_have_history(hash))
+    {
+        send_history_result(code(), block_chain::history(), request,
+            queue_send);
+        return;
+    }
+
+    history_handler handler =
         std::bind(send_history_result,
             _1, _2, request, queue_send);
 
+    // Only complete histories are cached.
+    auto& hot = node.hot_addresses();
+    if (hot.record(hash) && from_height == 0)
+    {
+        uint64_t generation;
+        hot_address_cache::result cached;
+        const auto from = hot_address_cache::source::pool;
+        if (hot.fetch(hash, from, cached, generation))
+        {
+            const outgoing_message response(request, cached.payload);
+            queue_send(response);
+            return;
+        }
+
+        handler = cache_history_result(hot, hash, from, generation, handler);
+    }
+
     fetch_history(node.blockchain(), node.transaction_indexer(), address,
         handler, from_height);
 }
@@ -19,6 +19,15 @@
  */
 #include <bitcoin/server/service/blockchain.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <boost/iostreams/stream.hpp>
 #include <bitcoin/server/server_node.hpp>
 #include <bitcoin/server/service/fetch_x.hpp>
@@ -42,12 +51,37 @@ void blockchain_fetch_history(server_node& node,
     if (!unwrap_fetch_history_args(address, from_height, request))
         return;
 
-    log::debug(LOG_REQUEST) << "blockchain.fetch_history("
-        << address.encoded() << ", from_height=" << from_height << ")";
+    // An address unknown to the chain has no history, without a read.
+    const auto& hash = address.hash();
+    if (!node.filters().may_have_history(hash))
+    {
+        send_history_result(code(), block_chain::history(), request,
+            queue_send);
+        return;
+    }
 
-    node.blockchain().fetch_history(address,
+    history_handler handler =
         std::bind(send_history_result,
-            _1, _2, request, queue_send), from_height);
+            _1, _2, request, queue_send);
+
+    // Only complete histories are cached.
+    auto& hot = node.hot_addresses();
+    if (hot.record(hash) && from_height == 0)
+    {
+        uint64_t generation;
+        hot_address_cache::result cached;
+        const auto from = hot_address_cache::source::chain;
+        if (hot.fetch(hash, from, cached, generation))
+        {
+            const outgoing_message response(request, cached.payload);
+            queue_send(response);
+            return;
+        }
+
+        handler = cache_history_result(hot, hash, from, generation, handler);
+    }
+
+    node.blockchain().fetch_history(address, handler, from_height);
 }
 
 void blockchain_fetch_transaction(server_node& node,
@@ -58,13 +92,257 @@ void blockchain_fetch_transaction(server_node& node,
     if (!unwrap_fetch_transaction_args(tx_hash, request))
         return;
 
-    log::debug(LOG_REQUEST) << "blockchain.fetch_transaction("
-        << encode_hash(tx_hash) << ")";
+    if (!node.filters().may_have_transaction(tx_hash))
+    {
+        transaction_fetched(bc::error::not_found, chain::transaction(),
+            request, queue_send);
+        return;
+    }
 
     node.blockchain().fetch_transaction(tx_hash,
         std::bind(transaction_fetched, _1, _2, request, queue_send));
 }
 
+// The most transactions fetched by one request.
+static constexpr size_t maximum_transactions = 1000;
+
+typedef std::pair<code, chain::transaction> transaction_result;
+typedef std::vector<transaction_result> transaction_results;
+typedef std::function<void (const transaction_results&)>
+    transactions_handler;
+
+// The results of a batch of transaction lookups, each written by its own
+// lookup, with the handler invoked by the last lookup to complete.
+struct transactions_fetch
+{
+    typedef std::shared_ptr<transactions_fetch> ptr;
+
+    transactions_fetch(size_t count, transactions_handler handler)
+      : results(count), remaining(count), handler(handler)
+    {
+    }
+
+    transaction_results results;
+    std::atomic<size_t> remaining;
+    const transactions_handler handler;
+};
+
+static void batch_transaction_fetched(const code& ec,
+    const chain::transaction& tx, size_t index, transactions_fetch::ptr fetch)
+{
+    fetch->results[index] = std::make_pair(ec, tx);
+
+    // Pairs with the other lookups' decrements so all results are visible.
+    if (fetch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        fetch->handler(fetch->results);
+}
+
+// A transaction not in the chain may be in the memory pool.
+static void chain_transaction_fetched(server_node& node, const code& ec,
+    const chain::transaction& tx, const hash_digest& tx_hash, size_t index,
+    transactions_fetch::ptr fetch)
+{
+    if (ec != bc::error::not_found)
+    {
+        batch_transaction_fetched(ec, tx, index, fetch);
+        return;
+    }
+
+    node.transaction_pool().fetch(tx_hash,
+        std::bind(batch_transaction_fetched, _1, _2, index, fetch));
+}
+
+// Look up the transactions in parallel on the blockchain threadpool, or else
+// in the memory pool, with the results in the order of the hashes.
+static void fetch_transactions(server_node& node,
+    const hash_list& hashes, transactions_handler handler)
+{
+    if (hashes.empty())
+    {
+        handler(transaction_results());
+        return;
+    }
+
+    const auto fetch = std::make_shared<transactions_fetch>(hashes.size(),
+        handler);
+
+    for (size_t index = 0; index < hashes.size(); ++index)
+    {
+        const auto& tx_hash = hashes[index];
+
+        if (!node.filters().may_have_transaction(tx_hash))
+        {
+            batch_transaction_fetched(bc::error::not_found,
+                chain::transaction(), index, fetch);
+            continue;
+        }
+
+        node.blockchain().fetch_transaction(tx_hash,
+            std::bind(chain_transaction_fetched, std::ref(node),
+                _1, _2, tx_hash, index, fetch));
+    }
+}
+
+static void transactions_fetched(const transaction_results& results,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    request.stamp(request_trace::point::database);
+
+    size_t size = 4;
+    for (const auto& result: results)
+        size += 4 + (result.first ? 0 : result.second.serialized_size());
+
+    // Serialize into the reply, which is then moved into the message.
+    data_chunk data;
+    data.reserve(size);
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    write_error_code(sink, code());
+
+    for (const auto& result: results)
+    {
+        write_error_code(sink, result.first);
+        if (!result.first)
+            result.second.to_data(ostream);
+    }
+
+    ostream.flush();
+    BITCOIN_ASSERT(data.size() == size);
+    const outgoing_message response(request, std::move(data));
+    queue_send(response);
+}
+
+void blockchain_fetch_transactions(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    const auto& data = request.data();
+    const auto count = data.size() / hash_size;
+
+    if (data.empty() || data.size() % hash_size != 0 ||
+        count > maximum_transactions)
+    {
+        log::error(LOG_SERVICE)
+            << "Incorrect data size for blockchain.fetch_transactions";
+        return;
+    }
+
+    hash_list hashes;
+    hashes.reserve(count);
+    auto deserial = make_deserializer(data.begin(), data.end());
+    for (size_t index = 0; index < count; ++index)
+        hashes.push_back(deserial.read_hash());
+
+    fetch_transactions(node, hashes,
+        std::bind(transactions_fetched, _1, request, queue_send));
+}
+
+static void prevouts_fetched(const code& ec, const chain::transaction& tx,
+    const std::vector<size_t>& sources, const transaction_results& results,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    request.stamp(request_trace::point::database);
+
+    // The output spent by each input, null if it was not found.
+    std::vector<const chain::output*> outputs;
+    outputs.reserve(tx.inputs.size());
+    for (size_t index = 0; !ec && index < tx.inputs.size(); ++index)
+    {
+        const auto& point = tx.inputs[index].previous_output;
+        const auto source = sources[index];
+        const chain::output* output = nullptr;
+
+        if (source < results.size() && !results[source].first &&
+            point.index < results[source].second.outputs.size())
+            output = &results[source].second.outputs[point.index];
+
+        outputs.push_back(output);
+    }
+
+    size_t size = 4 + (ec ? 0 : tx.serialized_size());
+    for (const auto output: outputs)
+        size += 4 + (output == nullptr ? 0 : output->serialized_size());
+
+    // Serialize into the reply, which is then moved into the message.
+    data_chunk data;
+    data.reserve(size);
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    write_error_code(sink, ec);
+
+    if (!ec)
+    {
+        tx.to_data(ostream);
+
+        for (const auto output: outputs)
+        {
+            write_error_code(sink, output == nullptr ?
+                bc::error::not_found : code());
+
+            if (output != nullptr)
+                output->to_data(ostream);
+        }
+    }
+
+    ostream.flush();
+    BITCOIN_ASSERT(data.size() == size);
+    const outgoing_message response(request, std::move(data));
+    queue_send(response);
+}
+
+static void prevouts_transaction_fetched(server_node& node,
+    const transaction_results& results, const incoming_message& request,
+    queue_send_callback queue_send)
+{
+    BITCOIN_ASSERT(results.size() == 1);
+    const auto& ec = results.front().first;
+    const auto& tx = results.front().second;
+    if (ec)
+    {
+        prevouts_fetched(ec, tx, {}, {}, request, queue_send);
+        return;
+    }
+
+    // Each previous transaction is fetched once, however many inputs spend
+    // it. Coinbase inputs have no source and get not_found.
+    const auto no_source = std::numeric_limits<size_t>::max();
+    std::vector<size_t> sources;
+    sources.reserve(tx.inputs.size());
+    hash_list hashes;
+    std::unordered_map<hash_digest, size_t> indexes;
+
+    for (const auto& input: tx.inputs)
+    {
+        const auto& point = input.previous_output;
+        if (point.is_null())
+        {
+            sources.push_back(no_source);
+            continue;
+        }
+
+        const auto it = indexes.emplace(point.hash, hashes.size());
+        if (it.second)
+            hashes.push_back(point.hash);
+
+        sources.push_back(it.first->second);
+    }
+
+    fetch_transactions(node, hashes,
+        std::bind(prevouts_fetched, code(), tx, sources, _1, request,
+            queue_send));
+}
+
+void blockchain_fetch_transaction_with_prevouts(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    hash_digest tx_hash;
+    if (!unwrap_fetch_transaction_args(tx_hash, request))
+        return;
+
+    fetch_transactions(node, { tx_hash },
+        std::bind(prevouts_transaction_fetched, std::ref(node), _1,
+            request, queue_send));
+}
+
 void last_height_fetched(const code& ec, size_t last_height,
     const incoming_message& request, queue_send_callback queue_send);
 
@@ -87,6 +365,7 @@ void blockchain_fetch_last_height(server_node& node,
 void last_height_fetched(const code& ec, size_t last_height,
     const incoming_message& request, queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     BITCOIN_ASSERT(last_height <= bc::max_uint32);
     auto last_height32 = static_cast<uint32_t>(last_height);
 
@@ -95,8 +374,6 @@ void last_height_fetched(const code& ec, size_t last_height,
     write_error_code(serial, ec);
     serial.write_4_bytes_little_endian(last_height32);
     BITCOIN_ASSERT(serial.iterator() == result.end());
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_last_height() finished. Sending response.";
     const outgoing_message response(request, result);
     queue_send(response);
 }
@@ -149,91 +426,281 @@ void fetch_block_header_by_height(server_node& node,
 void block_header_fetched(const code& ec, const chain::header& block,
     const incoming_message& request, queue_send_callback queue_send)
 {
-    data_chunk result(4 + block.serialized_size(false));
+    request.stamp(request_trace::point::database);
+
+    // Serialize into the reply, which is then moved into the message.
+    data_chunk result;
+    result.reserve(4 + block.serialized_size(false));
+    data_sink ostream(result);
+    ostream_writer sink(ostream);
+    write_error_code(sink, ec);
+    block.to_data(ostream, false);
+    ostream.flush();
+
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
+}
+
+// The most headers fetched by one request, as the p2p headers message.
+static constexpr size_t maximum_headers = 2000;
+
+// The lookups in flight for one request the header store cannot answer.
+static constexpr size_t headers_lookup_window = 16;
+
+typedef std::pair<code, chain::header> header_result;
+
+// The lookups of a header range the store cannot answer, each written by
+// its own lookup, which starts the next, with the reply sent by the last
+// lookup to complete.
+struct headers_fetch
+{
+    typedef std::shared_ptr<headers_fetch> ptr;
+
+    headers_fetch(block_chain& chain, size_t start, size_t count,
+        const incoming_message& request, queue_send_callback queue_send)
+      : chain(chain), start(start), results(count), next(0),
+        remaining(count), request(request), queue_send(queue_send)
+    {
+    }
+
+    block_chain& chain;
+    const size_t start;
+    std::vector<header_result> results;
+    std::atomic<size_t> next;
+    std::atomic<size_t> remaining;
+    const incoming_message request;
+    const queue_send_callback queue_send;
+};
+
+static void send_headers(const code& ec, data_chunk&& result,
+    const incoming_message& request, queue_send_callback queue_send)
+{
     auto serial = make_serializer(result.begin());
     write_error_code(serial, ec);
-    BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
+}
 
-    data_chunk block_data = block.to_data(false);
-    serial.write_data(block_data);
-    BITCOIN_ASSERT(serial.iterator() == result.end());
+static void range_header_fetched(const code& ec, const chain::header& header,
+    size_t index, headers_fetch::ptr fetch);
 
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_block_header() finished. Sending response.";
-    const outgoing_message response(request, result);
-    queue_send(response);
+static void fetch_range_header(headers_fetch::ptr fetch)
+{
+    const auto index = fetch->next++;
+    if (index < fetch->results.size())
+        fetch->chain.fetch_block_header(fetch->start + index,
+            std::bind(range_header_fetched, _1, _2, index, fetch));
 }
 
-////void fetch_block_transaction_hashes_by_hash(server_node& node,
-////    const incoming_message& request, queue_send_callback queue_send);
-
-////void fetch_block_transaction_hashes_by_height(server_node& node,
-////    const incoming_message& request, queue_send_callback queue_send);
-
-////void block_transaction_hashes_fetched(const code& ec,
-////    const hash_list& hashes,
-////    const incoming_message& request, queue_send_callback queue_send);
-
-////void blockchain_fetch_block_transaction_hashes(server_node& node,
-////    const incoming_message& request, queue_send_callback queue_send)
-////{
-////    const auto& data = request.data();
-////    if (data.size() == 32)
-////        fetch_block_transaction_hashes_by_hash(node, request, queue_send);
-////    //else if (data.size() == 4)
-////    //    fetch_block_transaction_hashes_by_height(node, request, queue_send);
-////    else
-////    {
-////        log::error(LOG_SERVICE) << "Incorrect data size for "
-////            "blockchain.fetch_block_transaction_hashes_by_height";
-////        return;
-////    }
-////}
-
-////void fetch_block_transaction_hashes_by_hash(server_node& node,
-////    const incoming_message& request, queue_send_callback queue_send)
-////{
-////    const auto& data = request.data();
-////    BITCOIN_ASSERT(data.size() == 32);
-////    auto deserial = make_deserializer(data.begin(), data.end());
-////    const auto block_hash = deserial.read_hash();
-////    node.blockchain().fetch_block_transaction_hashes(block_hash,
-////        std::bind(block_transaction_hashes_fetched,
-////            _1, _2, request, queue_send));
-////}
-
-// Disabled because method no longer exists in libbitcoin.
-// I'm not actually sure that it's useful when we have fetch by hash instead.
-/**
+// The reply is the headers below the first failed lookup, if that and every
+// later lookup is above the top of the chain. Any other failure fails the
+// request rather than truncate it within the chain.
+static void range_header_fetched(const code& ec, const chain::header& header,
+    size_t index, headers_fetch::ptr fetch)
+{
+    fetch->results[index] = { ec, header };
+    fetch_range_header(fetch);
+    if (--fetch->remaining > 0)
+        return;
+
+    fetch->request.stamp(request_trace::point::database);
+    const auto& results = fetch->results;
+
+    size_t found = 0;
+    while (found < results.size() && !results[found].first)
+        ++found;
+
+    auto status = found == 0 ? code(bc::error::not_found) : code();
+    for (auto it = results.begin() + found; it != results.end(); ++it)
+    {
+        if (it->first && it->first != bc::error::not_found)
+        {
+            status = it->first;
+            found = 0;
+            break;
+        }
+    }
+
+    data_chunk result(4);
+    result.reserve(4 + found * header_store::header_size);
+    data_sink ostream(result);
+    for (size_t position = 0; position < found; ++position)
+        results[position].second.to_data(ostream, false);
+
+    ostream.flush();
+    send_headers(status, std::move(result), fetch->request,
+        fetch->queue_send);
+}
+
+void blockchain_fetch_block_headers(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    const auto& data = request.data();
+    if (data.size() != 8)
+    {
+        log::error(LOG_SERVICE)
+            << "Incorrect data size for blockchain.fetch_block_headers";
+        return;
+    }
+
+    auto deserial = make_deserializer(data.begin(), data.end());
+    const size_t start = deserial.read_4_bytes_little_endian();
+    const size_t count = std::min<size_t>(
+        deserial.read_4_bytes_little_endian(), maximum_headers);
+
+    // An empty range has nothing to look up, with or without the store.
+    if (count == 0)
+    {
+        send_headers(bc::error::not_found, data_chunk(4), request,
+            queue_send);
+        return;
+    }
+
+    // The headers are copied from the store after the error code.
+    data_chunk result(4);
+    result.reserve(4 + count * header_store::header_size);
+    if (node.headers().read(start, count, result))
+    {
+        const auto ec = result.size() == 4 ?
+            code(bc::error::not_found) : code();
+        send_headers(ec, std::move(result), request, queue_send);
+        return;
+    }
+
+    // Until the store is loaded, headers beyond it are looked up a window
+    // at a time, so that one request cannot fill the blockchain threads.
+    const auto fetch = std::make_shared<headers_fetch>(node.blockchain(),
+        start, count, request, queue_send);
+
+    for (size_t lookup = 0; lookup < headers_lookup_window; ++lookup)
+        fetch_range_header(fetch);
+}
+
+// An offset and count may follow the block key of a hash list request.
+static constexpr size_t hashes_range_size = 8;
+
+// The range of transaction hashes requested, the whole list by default.
+struct hashes_range
+{
+    size_t offset;
+    size_t count;
+};
+
+template <typename Deserializer>
+static hashes_range unwrap_hashes_range(Deserializer& deserial, bool ranged)
+{
+    hashes_range range{ 0, max_size_t };
+    if (ranged)
+    {
+        range.offset = deserial.read_4_bytes_little_endian();
+        range.count = deserial.read_4_bytes_little_endian();
+    }
+
+    return range;
+}
+
+void fetch_block_transaction_hashes_by_hash(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
+
 void fetch_block_transaction_hashes_by_height(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send);
+
+void block_hash_fetched(const code& ec, const chain::header& block,
+    server_node& node, const hashes_range& range,
+    const incoming_message& request, queue_send_callback queue_send);
+
+void block_transaction_hashes_fetched(const code& ec,
+    const hash_list& hashes, const hashes_range& range,
+    const incoming_message& request, queue_send_callback queue_send);
+
+void blockchain_fetch_block_transaction_hashes(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    const auto& data = request.data();
+
+    if (data.size() == 32 || data.size() == 32 + hashes_range_size)
+        fetch_block_transaction_hashes_by_hash(node, request, queue_send);
+    else if (data.size() == 4 || data.size() == 4 + hashes_range_size)
+        fetch_block_transaction_hashes_by_height(node, request, queue_send);
+    else
+        log::error(LOG_SERVICE) << "Incorrect data size for "
+            "blockchain.fetch_block_transaction_hashes";
+}
+
+void fetch_block_transaction_hashes_by_hash(server_node& node,
     const incoming_message& request, queue_send_callback queue_send)
 {
     const auto& data = request.data();
-    BITCOIN_ASSERT(data.size() == 4);
     auto deserial = make_deserializer(data.begin(), data.end());
-    const size_t height = deserial.read_4_bytes();
-    node.blockchain().fetch_block_transaction_hashes(height,
+    const auto block_hash = deserial.read_hash();
+    const auto range = unwrap_hashes_range(deserial, data.size() > 32);
+    node.blockchain().fetch_block_transaction_hashes(block_hash,
         std::bind(block_transaction_hashes_fetched,
-            _1, _2, request, queue_send));
-}
-*/
-
-////void block_transaction_hashes_fetched(const code& ec,
-////    const hash_list& hashes,
-////    const incoming_message& request, queue_send_callback queue_send)
-////{
-////    data_chunk result(4 + hash_size * hashes.size());
-////    auto serial = make_serializer(result.begin());
-////    write_error_code(serial, ec);
-////    BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
-////    for (const auto& tx_hash: hashes)
-////        serial.write_hash(tx_hash);
-////    BITCOIN_ASSERT(serial.iterator() == result.end());
-////    log::debug(LOG_REQUEST) << "blockchain.fetch_block_transaction_hashes()"
-////       " finished. Sending response.";
-////    const outgoing_message response(request, result);
-////    queue_send(response);
-////}
+            _1, _2, range, request, queue_send));
+}
+
+// The hash list is keyed by block hash, which the header store resolves
+// without a read once loaded.
+void fetch_block_transaction_hashes_by_height(server_node& node,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    const auto& data = request.data();
+    auto deserial = make_deserializer(data.begin(), data.end());
+    const size_t height = deserial.read_4_bytes_little_endian();
+    const auto range = unwrap_hashes_range(deserial, data.size() > 4);
+
+    hash_digest block_hash;
+    if (node.headers().block_hash(height, block_hash))
+    {
+        node.blockchain().fetch_block_transaction_hashes(block_hash,
+            std::bind(block_transaction_hashes_fetched,
+                _1, _2, range, request, queue_send));
+        return;
+    }
+
+    node.blockchain().fetch_block_header(height,
+        std::bind(block_hash_fetched,
+            _1, _2, std::ref(node), range, request, queue_send));
+}
+
+void block_hash_fetched(const code& ec, const chain::header& block,
+    server_node& node, const hashes_range& range,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    if (ec)
+    {
+        block_transaction_hashes_fetched(ec, hash_list(), range, request,
+            queue_send);
+        return;
+    }
+
+    node.blockchain().fetch_block_transaction_hashes(block.hash(),
+        std::bind(block_transaction_hashes_fetched,
+            _1, _2, range, request, queue_send));
+}
+
+void block_transaction_hashes_fetched(const code& ec,
+    const hash_list& hashes, const hashes_range& range,
+    const incoming_message& request, queue_send_callback queue_send)
+{
+    request.stamp(request_trace::point::database);
+
+    const auto first = std::min(range.offset, hashes.size());
+    const auto count = std::min(range.count, hashes.size() - first);
+
+    data_chunk result(4);
+    result.reserve(4 + count * hash_size);
+    auto serial = make_serializer(result.begin());
+    write_error_code(serial, ec);
+
+    // The hash list is contiguous, so the range is copied as one block.
+    static_assert(sizeof(hash_digest) == hash_size, "padded hash_digest");
+    const auto bytes = reinterpret_cast<const uint8_t*>(hashes.data() + first);
+    result.insert(result.end(), bytes, bytes + count * hash_size);
+
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
+}
 
 void transaction_index_fetched(const code& ec,
     size_t block_height, size_t index,
@@ -261,6 +728,7 @@ void transaction_index_fetched(const code& ec,
     size_t block_height, size_t index,
     const incoming_message& request, queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     BITCOIN_ASSERT(index <= max_uint32);
     auto index32 = static_cast<uint32_t>(index);
     BITCOIN_ASSERT(block_height <= max_uint32);
@@ -273,8 +741,6 @@ void transaction_index_fetched(const code& ec,
     BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
     serial.write_4_bytes_little_endian(block_height32);
     serial.write_4_bytes_little_endian(index32);
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_transaction_index() finished. Sending response.";
     const outgoing_message response(request, result);
     queue_send(response);
 }
@@ -302,6 +768,13 @@ void blockchain_fetch_spend(server_node& node,
     chain::output_point outpoint;
     outpoint.from_data(istream);
 
+    if (!node.filters().may_be_spent(outpoint))
+    {
+        spend_fetched(bc::error::unspent_output, chain::input_point(),
+            request, queue_send);
+        return;
+    }
+
     node.blockchain().fetch_spend(outpoint,
         std::bind(spend_fetched, _1, _2, request, queue_send));
 }
@@ -310,6 +783,7 @@ void spend_fetched(const code& ec,
     const chain::input_point& inpoint, const incoming_message& request,
     queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     // error_code (4), hash (32), index (4)
     data_chunk result(4 + inpoint.serialized_size());
     auto serial = make_serializer(result.begin());
@@ -317,8 +791,6 @@ void spend_fetched(const code& ec,
     BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
     data_chunk raw_inpoint = inpoint.to_data();
     serial.write_data(raw_inpoint);
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_spend() finished. Sending response.";
     const outgoing_message response(request, result);
     queue_send(response);
 }
@@ -347,6 +819,7 @@ void blockchain_fetch_block_height(server_node& node,
 void block_height_fetched(const code& ec, size_t block_height,
     const incoming_message& request, queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     BITCOIN_ASSERT(block_height <= max_uint32);
     auto block_height32 = static_cast<uint32_t>(block_height);
 
@@ -356,16 +829,10 @@ void block_height_fetched(const code& ec, size_t block_height,
     write_error_code(serial, ec);
     BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
     serial.write_4_bytes_little_endian(block_height32);
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_block_height() finished. Sending response.";
     const outgoing_message response(request, result);
     queue_send(response);
 }
 
-void stealth_fetched(const code& ec,
-    const block_chain::stealth& stealth_results,
-    const incoming_message& request, queue_send_callback queue_send);
-
 void blockchain_fetch_stealth(server_node& node,
     const incoming_message& request, queue_send_callback queue_send)
 {
@@ -406,6 +873,7 @@ void stealth_fetched(
     const code& ec, const block_chain::stealth& stealth_results,
     const incoming_message& request, queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     // [ ephemkey:32 ][ address:20 ][ tx_hash:32 ]
     static constexpr size_t row_size = 32 + 20 + 32;
     data_chunk result(4 + row_size * stealth_results.size());
@@ -420,9 +888,7 @@ void stealth_fetched(
         serial.write_hash(row.transaction_hash);
     }
 
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_stealth() finished. Sending response.";
-    const outgoing_message response(request, result);
+    const outgoing_message response(request, std::move(result));
     queue_send(response);
 }
 
@@ -19,6 +19,7 @@
  */
 #include <bitcoin/server/service/compat.hpp>
 
+#include <utility>
 #include <bitcoin/server/server_node.hpp>
 #include <bitcoin/server/service/fetch_x.hpp>
 
@@ -40,10 +41,6 @@ struct row_pair
 
 typedef std::vector<row_pair> row_pair_list;
 
-void COMPAT_send_history_result(const code& ec,
-    const block_chain::history& history, const incoming_message& request,
-    queue_send_callback queue_send, const uint64_t from_height);
-
 void COMPAT_fetch_history(server_node& node,
     const incoming_message& request, queue_send_callback queue_send)
 {
@@ -58,22 +55,49 @@ void COMPAT_fetch_history(server_node& node,
     auto address_hash = address_in.hash();
     std::reverse(address_hash.begin(), address_hash.end());
 
-    // TODO: Slows down queries!
-    //log::debug(LOG_SERVICE) << "fetch_history("
-    //    << address.encoded() << ", from_height=" << from_height << ")";
-
     constexpr size_t history_from_height = 0;
     wallet::payment_address address_out(address_hash, address_version);
 
-    fetch_history(node.blockchain(), node.transaction_indexer(), address_out,
+    // An address unknown to the chain and pool has no history.
+    if (!node.filters().may_have_history(address_hash))
+    {
+        COMPAT_send_history_result(code(), block_chain::history(), request,
+            queue_send, from_height);
+        return;
+    }
+
+    history_handler handler =
         std::bind(COMPAT_send_history_result,
-            _1, _2, request, queue_send, from_height), history_from_height);
+            _1, _2, request, queue_send, from_height);
+
+    // The complete history is always read, so it is always cacheable, and
+    // is shared with address.fetch_history2.
+    auto& hot = node.hot_addresses();
+    if (hot.record(address_hash))
+    {
+        uint64_t generation;
+        hot_address_cache::result cached;
+        const auto from = hot_address_cache::source::pool;
+        if (hot.fetch(address_hash, from, cached, generation))
+        {
+            COMPAT_send_history_result(code(), *cached.history, request,
+                queue_send, from_height);
+            return;
+        }
+
+        handler = cache_history_result(hot, address_hash, from, generation,
+            handler);
+    }
+
+    fetch_history(node.blockchain(), node.transaction_indexer(), address_out,
+        handler, history_from_height);
 }
 
 void COMPAT_send_history_result(const code& ec,
     const block_chain::history& history, const incoming_message& request,
     queue_send_callback queue_send, const uint64_t from_height)
 {
+    request.stamp(request_trace::point::database);
     // Create matched pairs.
     // First handle outputs.
     row_pair_list all_pairs;
@@ -170,11 +194,7 @@ void COMPAT_send_history_result(const code& ec,
 
     BITCOIN_ASSERT(serial.iterator() == result.end());
 
-    // TODO: Slows down queries!
-    //log::debug(LOG_SERVICE)
-    //    << "*.fetch_history() finished. Sending response.";
-
-    outgoing_message response(request, result);
+    outgoing_message response(request, std::move(result));
     queue_send(response);
 }
 
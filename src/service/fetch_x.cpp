@@ -19,7 +19,10 @@
  */
 #include <bitcoin/server/service/fetch_x.hpp>
 
+#include <memory>
+#include <utility>
 #include <bitcoin/server/config/configuration.hpp>
+#include <bitcoin/server/hot_address_cache.hpp>
 #include <bitcoin/server/service/util.hpp>
 
 namespace libbitcoin {
@@ -51,9 +54,7 @@ bool unwrap_fetch_history_args(wallet::payment_address& address,
     return true;
 }
 
-void send_history_result(const code& ec,
-    const block_chain::history& history, const incoming_message& request,
-    queue_send_callback queue_send)
+data_chunk history_result(const code& ec, const block_chain::history& history)
 {
     constexpr size_t row_size = 1 + 36 + 4 + 8;
     data_chunk result(4 + row_size * history.size());
@@ -77,15 +78,39 @@ void send_history_result(const code& ec,
     }
 
     BITCOIN_ASSERT(serial.iterator() == result.end());
+    return result;
+}
 
-    // TODO: Slows down queries!
-    //log::debug(LOG_SERVICE)
-    //    << "*.fetch_history() finished. Sending response.";
-
-    outgoing_message response(request, result);
+void send_history_result(const code& ec,
+    const block_chain::history& history, const incoming_message& request,
+    queue_send_callback queue_send)
+{
+    request.stamp(request_trace::point::database);
+    outgoing_message response(request, history_result(ec, history));
     queue_send(response);
 }
 
+// Caches a history read from the database for a hot address, with its
+// response serialized, before passing it on.
+history_handler cache_history_result(hot_address_cache& cache,
+    const short_hash& hash, hot_address_cache::source from,
+    uint64_t generation, history_handler handler)
+{
+    return [&cache, hash, from, generation, handler](const code& ec,
+        const block_chain::history& history)
+    {
+        if (!ec)
+        {
+            const auto rows =
+                std::make_shared<const block_chain::history>(history);
+            cache.store(hash, from, generation, rows,
+                history_result(ec, history));
+        }
+
+        handler(ec, history);
+    };
+}
+
 // fetch_transaction stuff
 
 bool unwrap_fetch_transaction_args(hash_digest& tx_hash,
@@ -109,19 +134,18 @@ void transaction_fetched(const code& ec,
     const chain::transaction& tx, const incoming_message& request,
     queue_send_callback queue_send)
 {
-    data_chunk result(4 + tx.serialized_size());
-    auto serial = make_serializer(result.begin());
-    write_error_code(serial, ec);
-    BITCOIN_ASSERT(serial.iterator() == result.begin() + 4);
-
-    data_chunk tx_data = tx.to_data();
-    serial.write_data(tx_data);
-    BITCOIN_ASSERT(serial.iterator() == result.end());
-
-    log::debug(LOG_REQUEST)
-        << "blockchain.fetch_transaction() finished. Sending response.";
-
-    outgoing_message response(request, result);
+    request.stamp(request_trace::point::database);
+
+    // Serialize into the reply, which is then moved into the message.
+    data_chunk result;
+    result.reserve(4 + tx.serialized_size());
+    data_sink ostream(result);
+    ostream_writer sink(ostream);
+    write_error_code(sink, ec);
+    tx.to_data(ostream);
+    ostream.flush();
+
+    outgoing_message response(request, std::move(result));
     queue_send(response);
 }
 
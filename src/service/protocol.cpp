@@ -73,9 +73,6 @@ void protocol_total_connections(server_node& node,
     serial.write_4_bytes_little_endian(total_connections32);
     BITCOIN_ASSERT(serial.iterator() == result.end());
 
-    log::debug(LOG_REQUEST)
-        << "protocol.total_connections() finished. Sending response.";
-
     outgoing_message response(request, result);
     queue_send(response);
 }
@@ -36,6 +36,7 @@ static void transaction_validated(const code& ec, const transaction& tx,
     const hash_digest& tx_hash, const index_list& unconfirmed,
     const incoming_message& request, queue_send_callback queue_send)
 {
+    request.stamp(request_trace::point::database);
     data_chunk result(4 + unconfirmed.size() * 4);
     auto serial = make_serializer(result.begin());
     write_error_code(serial, ec);
@@ -49,9 +50,6 @@ static void transaction_validated(const code& ec, const transaction& tx,
     }
 
     BITCOIN_ASSERT(serial.iterator() == result.end());
-    log::debug(LOG_REQUEST)
-        << "transaction_pool.validate() finished. Sending response: ec="
-        << ec.message();
 
     outgoing_message response(request, result);
     queue_send(response);
@@ -77,9 +75,6 @@ void transaction_pool_fetch_transaction(server_node& node,
     if (!unwrap_fetch_transaction_args(tx_hash, request))
         return;
 
-    log::debug(LOG_REQUEST) << "transaction_pool.fetch_transaction("
-        << encode_hash(tx_hash) << ")";
-
     node.transaction_pool().fetch(tx_hash,
         std::bind(transaction_fetched,
             _1, _2, request, queue_send));
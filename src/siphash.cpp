@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/siphash.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+static constexpr uint64_t short_id_mask = 0xffffffffffff;
+
+static inline uint64_t rotate_left(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2,
+    uint64_t& v3)
+{
+    v0 += v1;
+    v1 = rotate_left(v1, 13);
+    v1 ^= v0;
+    v0 = rotate_left(v0, 32);
+    v2 += v3;
+    v3 = rotate_left(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3 = rotate_left(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1 = rotate_left(v1, 17);
+    v1 ^= v2;
+    v2 = rotate_left(v2, 32);
+}
+
+static inline uint64_t read_word(const uint8_t* data, size_t size)
+{
+    uint64_t word = 0;
+    for (size_t byte = 0; byte < size; ++byte)
+        word |= static_cast<uint64_t>(data[byte]) << (8 * byte);
+
+    return word;
+}
+
+uint64_t siphash(const siphash_key& key, data_slice message)
+{
+    uint64_t v0 = 0x736f6d6570736575 ^ key.k0;
+    uint64_t v1 = 0x646f72616e646f6d ^ key.k1;
+    uint64_t v2 = 0x6c7967656e657261 ^ key.k0;
+    uint64_t v3 = 0x7465646279746573 ^ key.k1;
+
+    const auto data = message.data();
+    const auto size = message.size();
+    const auto whole = size - (size % 8);
+
+    for (size_t offset = 0; offset < whole; offset += 8)
+    {
+        const auto word = read_word(data + offset, 8);
+        v3 ^= word;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= word;
+    }
+
+    // The final word carries the remaining bytes and the message length.
+    const auto last = read_word(data + whole, size - whole) |
+        (static_cast<uint64_t>(size) << 56);
+
+    v3 ^= last;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+siphash_key short_id_key(data_slice raw_header, uint64_t nonce)
+{
+    data_chunk preimage(raw_header.begin(), raw_header.end());
+    extend_data(preimage, to_little_endian(nonce));
+    const auto digest = sha256_hash(preimage);
+    const auto k0 = from_little_endian_unsafe<uint64_t>(digest.begin());
+    const auto k1 = from_little_endian_unsafe<uint64_t>(digest.begin() + 8);
+    return { k0, k1 };
+}
+
+uint64_t short_id(const siphash_key& key, const hash_digest& tx_hash)
+{
+    return siphash(key, tx_hash) & short_id_mask;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/statistics.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/latency_histogram.hpp>
+#include <bitcoin/server/message.hpp>
+#include <bitcoin/server/service/util.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+static uint64_t microseconds(statistics::clock::duration elapsed)
+{
+    const auto count = std::chrono::duration_cast<
+        std::chrono::microseconds>(elapsed).count();
+    return count < 0 ? 0 : static_cast<uint64_t>(count);
+}
+
+statistics::request::request(command& stats, clock::time_point received)
+  : stats(stats), received(received), dispatched(received), replied(0)
+{
+}
+
+statistics::statistics()
+  : unhandled_(0), unanswered_(0)
+{
+}
+
+statistics::command& statistics::add(const std::string& name)
+{
+    auto& stats = commands_[name];
+    if (!stats)
+        stats.reset(new command);
+
+    return *stats;
+}
+
+void statistics::add_gauge(const std::string& name, gauge value)
+{
+    gauges_[name] = value;
+}
+
+statistics::request::ptr statistics::receive(command& stats, size_t bytes)
+{
+    ++stats.requests;
+    stats.bytes_in += bytes;
+    return std::make_shared<request>(stats, clock::now());
+}
+
+void statistics::dispatch(request& timing)
+{
+    timing.dispatched = clock::now();
+    timing.stats.queue.record(
+        microseconds(timing.dispatched - timing.received));
+}
+
+void statistics::reply(request& timing, const outgoing_message& message)
+{
+    auto& stats = timing.stats;
+    const auto& data = message.data();
+    stats.bytes_out += data.size();
+
+    // Subscriptions keep the handler of the subscribe request.
+    const auto now = clock::now();
+    clock::rep unreplied = 0;
+    if (!timing.replied.compare_exchange_strong(unreplied,
+        now.time_since_epoch().count()))
+    {
+        ++stats.notifications;
+        return;
+    }
+
+    ++stats.replies;
+    stats.handler.record(microseconds(now - timing.dispatched));
+
+    // Replies lead with a little endian error code.
+    if (data.size() >= sizeof(uint32_t) &&
+        from_little_endian_unsafe<uint32_t>(data.begin()) != 0)
+        ++stats.errors;
+}
+
+void statistics::sent(request& timing)
+{
+    const auto replied = timing.replied.load();
+    if (replied == 0)
+        return;
+
+    const clock::time_point reply_time{ clock::duration(replied) };
+    timing.stats.send.record(microseconds(clock::now() - reply_time));
+}
+
+void statistics::unhandled()
+{
+    ++unhandled_;
+}
+
+void statistics::unanswered()
+{
+    ++unanswered_;
+}
+
+// Each metric family is one group of lines led by its type, as the text
+// exposition format requires.
+std::string statistics::to_text() const
+{
+    typedef latency_histogram command::*stage;
+    typedef std::atomic<uint64_t> command::*count;
+    static const std::pair<const char*, stage> stages[] =
+    {
+        { "queue", &command::queue },
+        { "handler", &command::handler },
+        { "send", &command::send }
+    };
+
+    std::ostringstream text;
+
+    const auto labels = [](const std::string& name, const char* stage)
+    {
+        return "command=\"" + name + "\",stage=\"" + stage + "\"";
+    };
+
+    const auto counter = [&text, this](const std::string& metric,
+        count member)
+    {
+        text << "# TYPE bs_" << metric << "_total counter\n";
+        for (const auto& item: commands_)
+            text << "bs_" << metric << "_total{command=\"" << item.first
+                << "\"} " << (*item.second.*member).load() << "\n";
+    };
+
+    text << "# TYPE bs_latency_microseconds summary\n";
+    for (const auto& item: commands_)
+    {
+        for (const auto& stage: stages)
+        {
+            const auto& histogram = *item.second.*stage.second;
+            const auto names = labels(item.first, stage.first);
+
+            for (const auto quantile: quantiles)
+                text << "bs_latency_microseconds{" << names
+                    << ",quantile=\"" << quantile << "\"} "
+                    << histogram.quantile(quantile) << "\n";
+
+            text << "bs_latency_microseconds_sum{" << names << "} "
+                << histogram.sum() << "\n";
+            text << "bs_latency_microseconds_count{" << names << "} "
+                << histogram.count() << "\n";
+        }
+    }
+
+    text << "# TYPE bs_latency_max_microseconds gauge\n";
+    for (const auto& item: commands_)
+        for (const auto& stage: stages)
+            text << "bs_latency_max_microseconds{"
+                << labels(item.first, stage.first) << "} "
+                << (*item.second.*stage.second).maximum() << "\n";
+
+    counter("requests", &command::requests);
+    counter("replies", &command::replies);
+    counter("errors", &command::errors);
+    counter("notifications", &command::notifications);
+    counter("bytes_in", &command::bytes_in);
+    counter("bytes_out", &command::bytes_out);
+
+    text << "# TYPE bs_unhandled_total counter\n";
+    text << "bs_unhandled_total " << unhandled_ << "\n";
+    text << "# TYPE bs_unanswered_total counter\n";
+    text << "bs_unanswered_total " << unanswered_ << "\n";
+
+    for (const auto& item: gauges_)
+    {
+        text << "# TYPE bs_" << item.first << " gauge\n";
+        text << "bs_" << item.first << " " << item.second() << "\n";
+    }
+
+    return text.str();
+}
+
+void statistics::fetch(const incoming_message& request,
+    queue_send_callback queue_send)
+{
+    if (!request.data().empty())
+    {
+        log::error(LOG_SERVICE)
+            << "Incorrect data size for server.stats";
+        return;
+    }
+
+    const auto text = to_text();
+
+    // error_code (4), text (rest)
+    data_chunk result(4 + text.size());
+    auto serial = make_serializer(result.begin());
+    write_error_code(serial, code());
+    serial.write_data(data_chunk(text.begin(), text.end()));
+    BITCOIN_ASSERT(serial.iterator() == result.end());
+
+    const outgoing_message response(request, std::move(result));
+    queue_send(response);
+}
+
+} // namespace server
+} // namespace libbitcoin
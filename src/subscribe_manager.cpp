@@ -20,6 +20,8 @@
 #include <bitcoin/server/subscribe_manager.hpp>
 
 #include <cstdint>
+#include <mutex>
+#include <string>
 #include <boost/date_time.hpp>
 #include <bitcoin/server/config/configuration.hpp>
 #include <bitcoin/server/config/settings.hpp>
@@ -36,32 +38,60 @@ const auto now = []()
     return boost::posix_time::second_clock::universal_time();
 };
 
-static void register_with_node(subscribe_manager& manager, server_node& node)
-{
-    const auto receive_block = [&manager](size_t height, const block& block)
-    {
-        const auto block_hash = block.header.hash();
+using std::placeholders::_1;
 
-        for (const auto& tx: block.transactions)
-            manager.submit(height, block_hash, tx);
-    };
-
-    const auto receive_tx = [&manager](const transaction& tx)
-    {
-        constexpr size_t height = 0;
-        manager.submit(height, null_hash, tx);
-    };
-
-    node.subscribe_blocks(receive_block);
-    node.subscribe_transactions(receive_tx);
-}
+// Updates are handled in batches, each is cheap relative to a wakeup.
+static constexpr size_t subscriber_batch_size = 64;
 
 subscribe_manager::subscribe_manager(server_node& node,
     const settings& settings)
-  : dispatch_(node.pool()), settings_(settings)
+  : node_(node), dispatch_(node.pool()), size_(0), settings_(settings)
 {
     // subscribe to blocks and txs -> submit
-    register_with_node(*this, node);
+    consumer_ = node_.notifications().subscribe("subscriber",
+        std::bind(&subscribe_manager::receive, this, _1),
+        notification_bus::wait_strategy::blocking,
+        notification_bus::overflow_policy::drop, subscriber_batch_size);
+
+    node_.stats().add_gauge("subscriptions",
+        [this]() { return size_.load(); });
+}
+
+subscribe_manager::~subscribe_manager()
+{
+    node_.notifications().unsubscribe(consumer_);
+}
+
+// Updates are sent on the consumer thread rather than posted, so that a
+// subscription manager that falls behind is behind on the bus, where its
+// lag and skipped notifications are reported.
+void subscribe_manager::receive(const notification& item)
+{
+    switch (item.type)
+    {
+        case notification::kind::block:
+        {
+            const auto block_hash = item.block->header.hash();
+            for (const auto& analysis: item.analyses)
+                do_submit(item.height, block_hash, analysis);
+
+            break;
+        }
+        case notification::kind::disconnect:
+        {
+            const auto block_hash = item.block->header.hash();
+            for (const auto& analysis: item.analyses)
+                do_disconnect(item.height, block_hash, analysis);
+
+            break;
+        }
+        case notification::kind::transaction:
+        {
+            constexpr size_t height = 0;
+            do_submit(height, null_hash, item.analysis);
+            break;
+        }
+    }
 }
 
 static subscribe_type convert_subscribe_type(uint8_t type_byte)
@@ -109,6 +139,8 @@ code subscribe_manager::add_subscription(
         return error::bad_stream;
     }
 
+    std::lock_guard<std::mutex> lock(mutex_);
+
     // Limit absolute number of subscriptions to prevent exhaustion attacks.
     if (subscriptions_.size() >= settings_.subscription_limit)
         return error::pool_filled;
@@ -125,6 +157,7 @@ code subscribe_manager::add_subscription(
     };
 
     subscriptions_.emplace_back(new_subscription);
+    size_ = subscriptions_.size();
 
     return code();
 }
@@ -162,23 +195,27 @@ void subscribe_manager::do_renew(const incoming_message& request,
 
     const auto expire_time = now() + settings_.subscription_expiration();
 
-    // Find entry and update expiry_time.
-    for (auto& subscription: subscriptions_)
     {
-        if (subscription.type != type)
-            continue;
+        std::lock_guard<std::mutex> lock(mutex_);
 
-        // Only update subscriptions which were created by
-        // the same client as this request originated from.
-        if (subscription.client_origin != request.origin())
-            continue;
+        // Find entry and update expiry_time.
+        for (auto& subscription: subscriptions_)
+        {
+            if (subscription.type != type)
+                continue;
 
-        // Find matching subscription.
-        if (!subscription.prefix.is_prefix_of(filter))
-            continue;
+            // Only update subscriptions which were created by
+            // the same client as this request originated from.
+            if (subscription.client_origin != request.origin())
+                continue;
+
+            // Find matching subscription.
+            if (!subscription.prefix.is_prefix_of(filter))
+                continue;
 
-        // Future expiry time.
-        subscription.expiry_time = expire_time;
+            // Future expiry time.
+            subscription.expiry_time = expire_time;
+        }
     }
 
     // Send response.
@@ -190,7 +227,7 @@ void subscribe_manager::do_renew(const incoming_message& request,
 }
 
 void subscribe_manager::submit(size_t height, const hash_digest& block_hash,
-    const transaction& tx)
+    transaction_analysis::ptr tx)
 {
     dispatch_.ordered(
         &subscribe_manager::do_submit,
@@ -198,24 +235,23 @@ void subscribe_manager::submit(size_t height, const hash_digest& block_hash,
 }
 
 void subscribe_manager::do_submit(size_t height, const hash_digest& block_hash,
-    const transaction& tx)
+    transaction_analysis::ptr tx)
 {
-    for (const auto& input: tx.inputs)
-    {
-        const auto address = payment_address::extract(input.script);
-        if (address)
-            post_updates(address, height, block_hash, tx);
-    }
+    static const std::string update = "address.update";
+    static const std::string stealth_update = "address.stealth_update";
 
-    uint32_t prefix;
-    for (const auto& output: tx.outputs)
-    {
-        const auto address = payment_address::extract(output.script);
-        if (address)
-            post_updates(address, height, block_hash, tx);
-        else if (to_stealth_prefix(prefix, output.script))
-            post_stealth_updates(prefix, height, block_hash, tx);
-    }
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Addresses and prefixes are extracted once by the transaction cache.
+    for (const auto& address: tx->input_addresses)
+        post_updates(address, height, block_hash, tx->data, update);
+
+    for (const auto& address: tx->output_addresses)
+        post_updates(address, height, block_hash, tx->data, update);
+
+    for (const auto prefix: tx->stealth_prefixes)
+        post_stealth_updates(prefix, height, block_hash, tx->data,
+            stealth_update);
 
     // Periodicially sweep old expired entries.
     // Use the block 10 minute window as a periodic trigger.
@@ -223,8 +259,63 @@ void subscribe_manager::do_submit(size_t height, const hash_digest& block_hash,
         sweep_expired();
 }
 
+void subscribe_manager::disconnect(size_t height,
+    const hash_digest& block_hash, transaction_analysis::ptr tx)
+{
+    dispatch_.ordered(
+        &subscribe_manager::do_disconnect,
+            this, height, block_hash, tx);
+}
+
+// The height and block hash are those of the block being disconnected, so
+// clients can roll back confirmations without rescanning their history.
+void subscribe_manager::do_disconnect(size_t height,
+    const hash_digest& block_hash, transaction_analysis::ptr tx)
+{
+    static const std::string update = "address.disconnect";
+    static const std::string stealth_update = "address.stealth_disconnect";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& address: tx->input_addresses)
+        post_updates(address, height, block_hash, tx->data, update);
+
+    for (const auto& address: tx->output_addresses)
+        post_updates(address, height, block_hash, tx->data, update);
+
+    for (const auto prefix: tx->stealth_prefixes)
+        post_stealth_updates(prefix, height, block_hash, tx->data,
+            stealth_update);
+}
+
+void subscribe_manager::unsubscribe(const data_chunk& client_origin)
+{
+    dispatch_.ordered(
+        &subscribe_manager::do_unsubscribe,
+            this, client_origin);
+}
+void subscribe_manager::do_unsubscribe(const data_chunk& client_origin)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Delete all subscriptions of a disconnected client.
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();)
+    {
+        if (it->client_origin == client_origin)
+        {
+            it = subscriptions_.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+
+    size_ = subscriptions_.size();
+}
+
 void subscribe_manager::post_updates(const payment_address& address,
-    size_t height, const hash_digest& block_hash, const transaction& tx)
+    size_t height, const hash_digest& block_hash, const data_chunk& tx,
+    const std::string& command)
 {
     BITCOIN_ASSERT(height <= max_uint32);
     const auto height32 = static_cast<uint32_t>(height);
@@ -236,7 +327,7 @@ void subscribe_manager::post_updates(const payment_address& address,
     // [ tx ]
     static constexpr size_t info_size = 1 + short_hash_size + 4 + hash_size;
 
-    data_chunk data(info_size + tx.serialized_size());
+    data_chunk data(info_size + tx.size());
     auto serial = make_serializer(data.begin());
     serial.write_byte(address.version());
     serial.write_short_hash(address.hash());
@@ -245,8 +336,7 @@ void subscribe_manager::post_updates(const payment_address& address,
     BITCOIN_ASSERT(serial.iterator() == data.begin() + info_size);
 
     // Now write the tx part.
-    data_chunk tx_data = tx.to_data();
-    serial.write_data(tx_data);
+    serial.write_data(tx);
     BITCOIN_ASSERT(serial.iterator() == data.end());
 
     // Send the result to everyone interested.
@@ -258,15 +348,15 @@ void subscribe_manager::post_updates(const payment_address& address,
         if (!subscription.prefix.is_prefix_of(address.hash()))
             continue;
 
-        outgoing_message update(subscription.client_origin, "address.update",
-            data);
+        outgoing_message update(subscription.client_origin, command, data);
 
         subscription.queue_send(update);
     }
 }
 
-void subscribe_manager::post_stealth_updates(uint32_t prefix, size_t height, 
-    const hash_digest& block_hash, const transaction& tx)
+void subscribe_manager::post_stealth_updates(uint32_t prefix, size_t height,
+    const hash_digest& block_hash, const data_chunk& tx,
+    const std::string& command)
 {
     BITCOIN_ASSERT(height <= max_uint32);
     const auto height32 = static_cast<uint32_t>(height);
@@ -277,7 +367,7 @@ void subscribe_manager::post_stealth_updates(uint32_t prefix, size_t height,
     // [ tx ]
     static constexpr size_t info_size = 2 * sizeof(uint32_t) + hash_size;
 
-    data_chunk data(info_size + tx.serialized_size());
+    data_chunk data(info_size + tx.size());
     auto serial = make_serializer(data.begin());
     serial.write_4_bytes_little_endian(prefix);
     serial.write_4_bytes_little_endian(height32);
@@ -285,8 +375,7 @@ void subscribe_manager::post_stealth_updates(uint32_t prefix, size_t height,
     BITCOIN_ASSERT(serial.iterator() == data.begin() + info_size);
 
     // Now write the tx part.
-    data_chunk tx_data = tx.to_data();
-    serial.write_data(tx_data);
+    serial.write_data(tx);
     BITCOIN_ASSERT(serial.iterator() == data.end());
 
     // Send the result to everyone interested.
@@ -298,8 +387,7 @@ void subscribe_manager::post_stealth_updates(uint32_t prefix, size_t height,
             if (!subscription.prefix.is_prefix_of(prefix))
             continue;
 
-        outgoing_message update(subscription.client_origin,
-            "address.stealth_update", data);
+        outgoing_message update(subscription.client_origin, command, data);
 
         subscription.queue_send(update);
     }
@@ -327,6 +415,8 @@ void subscribe_manager::sweep_expired()
 
         ++it;
     }
+
+    size_ = subscriptions_.size();
 }
 
 } // namespace server
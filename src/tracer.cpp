@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/tracer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/server/config/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// All events are in one process, with a row (thread id) per trace.
+static constexpr uint32_t trace_process = 1;
+
+static const char* stage_names[request_trace::points] =
+{
+    "receive",
+    "queue",
+    "database",
+    "serialize",
+    "send_queue",
+    "send"
+};
+
+// Commands are read from clients before they are matched to a handler, so
+// they are escaped, with bytes outside printable ascii as code points.
+static std::string escape(const std::string& text)
+{
+    std::ostringstream out;
+    out << std::hex << std::setfill('0');
+    for (const auto character: text)
+    {
+        const auto byte = static_cast<uint8_t>(character);
+        if (character == '"' || character == '\\')
+            out << '\\' << character;
+        else if (byte < 0x20 || byte > 0x7e)
+            out << "\\u" << std::setw(4) << static_cast<uint32_t>(byte);
+        else
+            out << character;
+    }
+
+    return out.str();
+}
+
+request_trace::request_trace(uint64_t id, const std::string& command,
+    uint32_t request_id)
+  : id_(id), command_(command), request_id_(request_id)
+{
+    for (auto& time: times_)
+        time.store(0, std::memory_order_relaxed);
+}
+
+void request_trace::stamp(point at)
+{
+    using namespace std::chrono;
+    const auto now = duration_cast<microseconds>(
+        clock::now().time_since_epoch()).count();
+
+    // Zero is reserved for not stamped.
+    uint64_t unstamped = 0;
+    const auto stamp = std::max(static_cast<uint64_t>(now), uint64_t(1));
+    times_[static_cast<size_t>(at)].compare_exchange_strong(unstamped,
+        stamp, std::memory_order_release, std::memory_order_relaxed);
+}
+
+uint64_t request_trace::time(point at) const
+{
+    return times_[static_cast<size_t>(at)].load(std::memory_order_acquire);
+}
+
+uint64_t request_trace::id() const
+{
+    return id_;
+}
+
+const std::string& request_trace::command() const
+{
+    return command_;
+}
+
+uint32_t request_trace::request_id() const
+{
+    return request_id_;
+}
+
+tracer::tracer(const settings& settings)
+  : interval_(settings.trace_sample_interval),
+    settings_(settings),
+    requests_(0),
+    traces_(0),
+    first_event_(true)
+{
+}
+
+tracer::~tracer()
+{
+    stop();
+}
+
+bool tracer::start()
+{
+    if (interval_ == 0)
+        return true;
+
+    const auto& path = settings_.trace_file;
+    file_.open(path.string(), std::ios::out | std::ios::trunc);
+    if (!file_)
+    {
+        log::error(LOG_SERVICE)
+            << "Failed to open trace file " << path;
+        return false;
+    }
+
+    file_ << "[\n";
+    log::info(LOG_SERVICE)
+        << "Tracing one in " << interval_ << " requests to " << path;
+    return true;
+}
+
+void tracer::stop()
+{
+    if (!file_.is_open())
+        return;
+
+    file_ << "\n]\n";
+    file_.close();
+}
+
+request_trace::ptr tracer::sample(const std::string& command,
+    uint32_t request_id)
+{
+    if (!file_.is_open() || requests_++ % interval_ != 0)
+        return nullptr;
+
+    return std::make_shared<request_trace>(++traces_, command, request_id);
+}
+
+// Each stage runs from one stamped point to the next stamped point, so a
+// request with no reply still shows its dispatch.
+void tracer::write(const request_trace& trace)
+{
+    if (!file_.is_open())
+        return;
+
+    typedef request_trace::point point;
+    const auto begin = trace.time(point::receive);
+    if (begin == 0)
+        return;
+
+    auto previous = begin;
+    auto end = begin;
+    for (size_t index = 1; index < request_trace::points; ++index)
+    {
+        const auto time = trace.time(static_cast<point>(index));
+        if (time == 0)
+            continue;
+
+        write_event(trace, stage_names[index], previous, time);
+        previous = time;
+        end = time;
+    }
+
+    write_event(trace, trace.command(), begin, end);
+}
+
+void tracer::write_event(const request_trace& trace,
+    const std::string& name, uint64_t start, uint64_t end)
+{
+    if (!first_event_)
+        file_ << ",\n";
+
+    first_event_ = false;
+    file_ << "{\"name\":\"" << escape(name) << "\",\"cat\":\""
+        << escape(trace.command())
+        << "\",\"ph\":\"X\",\"ts\":" << start << ",\"dur\":"
+        << (end > start ? end - start : 0) << ",\"pid\":" << trace_process
+        << ",\"tid\":" << trace.id() << ",\"args\":{\"id\":"
+        << trace.request_id() << "}}";
+}
+
+void tracer::flush()
+{
+    if (file_.is_open())
+        file_.flush();
+}
+
+} // namespace server
+} // namespace libbitcoin
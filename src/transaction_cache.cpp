@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/transaction_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::chain;
+using namespace bc::wallet;
+
+static std::shared_ptr<transaction_analysis> analyze(const transaction& tx,
+    data_chunk&& data, const hash_digest& hash)
+{
+    auto analysis = std::make_shared<transaction_analysis>();
+    analysis->hash = hash;
+    analysis->data = std::move(data);
+
+    for (const auto& input: tx.inputs)
+    {
+        const auto address = payment_address::extract(input.script);
+        if (address)
+            analysis->input_addresses.push_back(address);
+    }
+
+    uint32_t prefix;
+    for (const auto& output: tx.outputs)
+    {
+        const auto address = payment_address::extract(output.script);
+        if (address)
+            analysis->output_addresses.push_back(address);
+        else if (to_stealth_prefix(prefix, output.script))
+            analysis->stealth_prefixes.push_back(prefix);
+    }
+
+    return analysis;
+}
+
+transaction_cache::transaction_cache(size_t capacity)
+  : capacity_(capacity), hits_(0), misses_(0)
+{
+}
+
+transaction_analysis::ptr transaction_cache::get(const transaction& tx,
+    const hash_digest& hash)
+{
+    const auto cached = find(hash);
+    if (cached)
+        return cached;
+
+    return store(analyze(tx, tx.to_data(), hash));
+}
+
+transaction_analysis::ptr transaction_cache::get(const transaction& tx,
+    data_chunk& buffer)
+{
+    // A transaction does not carry its hash, so a hit still serializes it,
+    // but into the reused buffer. Only a miss copies the serialization.
+    buffer.clear();
+    buffer.reserve(tx.serialized_size());
+    data_sink ostream(buffer);
+    tx.to_data(ostream);
+    ostream.flush();
+    const auto hash = bitcoin_hash(buffer);
+
+    const auto cached = find(hash);
+    if (cached)
+        return cached;
+
+    return store(analyze(tx, data_chunk(buffer), hash));
+}
+
+transaction_analysis::ptr transaction_cache::find(const hash_digest& hash)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = index_.find(hash);
+    if (it == index_.end())
+    {
+        ++misses_;
+        return nullptr;
+    }
+
+    // Move to most recently used.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    ++hits_;
+    return *it->second;
+}
+
+transaction_analysis::ptr transaction_cache::store(
+    transaction_analysis::ptr analysis)
+{
+    if (capacity_ == 0)
+        return analysis;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Another thread may have analyzed the same transaction concurrently.
+    const auto it = index_.find(analysis->hash);
+    if (it != index_.end())
+        return *it->second;
+
+    entries_.push_front(analysis);
+    index_[analysis->hash] = entries_.begin();
+
+    // Evict least recently used.
+    while (entries_.size() > capacity_)
+    {
+        index_.erase(entries_.back()->hash);
+        entries_.pop_back();
+    }
+
+    return analysis;
+}
+
+size_t transaction_cache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t transaction_cache::hits() const
+{
+    return hits_;
+}
+
+size_t transaction_cache::misses() const
+{
+    return misses_;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -19,13 +19,19 @@
  */
 #include <bitcoin/server/worker.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 #include <boost/date_time.hpp>
 #include <czmq++/czmqpp.hpp>
 #include <bitcoin/node.hpp>
 #include <bitcoin/server/config/configuration.hpp>
 #include <bitcoin/server/config/settings.hpp>
+#include <bitcoin/server/reply_tracker.hpp>
+#include <bitcoin/server/request_scheduler.hpp>
+#include <bitcoin/server/statistics.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -37,6 +43,20 @@ constexpr int zmq_false = 0;
 constexpr int zmq_fail = -1;
 constexpr int zmq_curve_enabled = zmq_true;
 constexpr int zmq_socket_no_linger = zmq_false;
+constexpr int zmq_router_mandatory = zmq_true;
+constexpr int zmq_send_no_wait = 0;
+
+// A request with no reply sent within this period is no longer timed.
+static const auto request_expiry = std::chrono::minutes(10);
+
+// A query with no reply within this period no longer counts against the
+// concurrency of its class, as a handler may drop a query after keeping its
+// reply callback for a lookup.
+static const auto running_expiry = std::chrono::seconds(30);
+
+// The wait of a poll while replies are queued for clients that have not yet
+// accepted them, or queries are deferred, neither of which wake the poller.
+static constexpr int busy_poll_milliseconds = 10;
 
 const auto now = []()
 {
@@ -66,17 +86,66 @@ void send_worker::queue_send(const outgoing_message& message)
     socket.destroy(context_);
 }
 
-request_worker::request_worker(const settings& settings)
+request_worker::request_worker(statistics& stats, const settings& settings)
   : socket_(context_, ZMQ_ROUTER),
     wakeup_socket_(context_, ZMQ_PULL),
     heartbeat_socket_(context_, ZMQ_PUB),
+    stats_socket_(context_, ZMQ_STREAM),
     authenticate_(context_),
     sender_(context_),
+    outbound_(settings),
+    stats_(stats),
+    tracer_(settings),
+    recorder_(settings.record_file),
+    logger_(settings),
+    scheduler_(settings),
     settings_(settings)
 {
     BITCOIN_ASSERT(socket_.self() != nullptr);
     BITCOIN_ASSERT(wakeup_socket_.self() != nullptr);
     BITCOIN_ASSERT(heartbeat_socket_.self() != nullptr);
+    BITCOIN_ASSERT(stats_socket_.self() != nullptr);
+
+    outbound_.set_sent_handler(
+        std::bind(&request_worker::handle_sent,
+            this, _1));
+
+    const auto total = [this](size_t client_queue::depth::*member)
+    {
+        uint64_t sum = 0;
+        for (const auto& client: outbound_.depths())
+            sum += client.second.*member;
+
+        return sum;
+    };
+
+    stats_.add_gauge("outbound_queue_clients",
+        [this]() { return outbound_.depths().size(); });
+    stats_.add_gauge("outbound_queue_messages",
+        std::bind(total, &client_queue::depth::messages));
+    stats_.add_gauge("outbound_queue_bytes",
+        std::bind(total, &client_queue::depth::bytes));
+    stats_.add_gauge("outbound_queue_dropped",
+        std::bind(total, &client_queue::depth::dropped));
+    stats_.add_gauge("pending_requests",
+        [this]() { return pending_.size(); });
+
+    for (const auto type: { request_class::cheap, request_class::normal,
+        request_class::expensive })
+    {
+        const auto name = request_scheduler::to_string(type);
+        stats_.add_gauge("scheduler_running_" + name,
+            std::bind(&request_scheduler::running, &scheduler_, type));
+        stats_.add_gauge("scheduler_deferred_" + name,
+            std::bind(&request_scheduler::deferred, &scheduler_, type));
+        stats_.add_gauge("scheduler_shed_" + name,
+            std::bind(&request_scheduler::shed, &scheduler_, type));
+    }
+
+    stats_.add_gauge("scheduler_limited",
+        std::bind(&request_scheduler::limited, &scheduler_));
+    stats_.add_gauge("request_log_dropped",
+        std::bind(&request_logger::dropped, &logger_));
 
     // Returns 0 if OK, -1 if the endpoint was invalid.
     int rc = wakeup_socket_.bind("inproc://trigger-send");
@@ -140,12 +209,36 @@ bool request_worker::start()
         << "Bound heartbeat service on "
         << settings_.heartbeat_endpoint;
 
+    if (settings_.stats_enabled)
+    {
+        // This binds the statistics service.
+        const auto rc = stats_socket_.bind(
+            settings_.stats_endpoint.to_string());
+        if (rc == 0)
+        {
+            log::error(LOG_SERVICE)
+                << "Failed to bind statistics service on "
+                << settings_.stats_endpoint;
+            return false;
+        }
+
+        log::info(LOG_SERVICE)
+            << "Bound statistics service on "
+            << settings_.stats_endpoint;
+    }
+
+    if (!tracer_.start() || !recorder_.start() || !logger_.start())
+        return false;
+
     deadline_ = now() + settings_.heartbeat_interval();
     return true;
 }
 
 bool request_worker::stop()
 {
+    tracer_.stop();
+    recorder_.stop();
+    logger_.stop();
     return true;
 }
 
@@ -200,15 +293,37 @@ bool request_worker::create_new_socket()
     const auto connected = rc != 0;
 
     if (connected)
+    {
         socket_.set_linger(zmq_socket_no_linger);
 
+        // Fail sends to full or lost peers so that client_queue can apply
+        // its slow consumer policy, rather than blocking or silently dropping.
+        zsocket_set_router_mandatory(socket_.self(), zmq_router_mandatory);
+        zsocket_set_sndtimeo(socket_.self(), zmq_send_no_wait);
+    }
+
     return connected;
 }
 
 void request_worker::attach(const std::string& command,
     command_handler handler)
 {
-    handlers_[command] = handler;
+    auto& entry = handlers_[command];
+    entry.handler = handler;
+    entry.stats = &stats_.add(command);
+    entry.type = request_scheduler::classify(command);
+    entry.name = &handlers_.find(command)->first;
+}
+
+void request_worker::set_disconnect_handler(
+    client_queue::disconnect_handler handler)
+{
+    outbound_.set_disconnect_handler(handler);
+}
+
+client_queue::depth_map request_worker::queue_depths() const
+{
+    return outbound_.depths();
 }
 
 void request_worker::update()
@@ -222,7 +337,16 @@ void request_worker::poll()
     czmqpp::poller poller(socket_, wakeup_socket_);
     BITCOIN_ASSERT(poller.self() != nullptr);
 
-    const auto which = poller.wait(settings_.polling_interval_seconds);
+    if (settings_.stats_enabled)
+        poller.add(stats_socket_);
+
+    // Cheap queries are never deferred.
+    const auto busy = outbound_.pending() ||
+        scheduler_.deferred(request_class::normal) != 0 ||
+        scheduler_.deferred(request_class::expensive) != 0;
+
+    const auto which = poller.wait(busy ? busy_poll_milliseconds :
+        static_cast<int>(settings_.polling_interval_seconds * 1000));
     BITCOIN_ASSERT(socket_.self() != nullptr);
     BITCOIN_ASSERT(wakeup_socket_.self() != nullptr);
 
@@ -231,22 +355,23 @@ void request_worker::poll()
         // Get message: 6-part envelope + content -> request
         incoming_message request;
         request.recv(socket_);
+        request.set_trace(tracer_.sample(request.command(), request.id()));
+        request.stamp(request_trace::point::receive);
+        recorder_.record(request);
 
         // Perform request if handler exists.
         auto it = handlers_.find(request.command());
         if (it != handlers_.end())
         {
-            if (settings_.log_requests)
-                log::debug(LOG_REQUEST)
-                    << "Service request [" << request.command() << "] from "
-                    << encode_base16(request.origin());
-
-            it->second(request,
-                std::bind(&send_worker::queue_send,
-                    &sender_, _1));
+            if (logger_.sampled(request))
+                logger_.log(request_logger::event::receive, it->first,
+                    request);
+
+            submit(request, it->second);
         }
         else
         {
+            stats_.unhandled();
             log::warning(LOG_SERVICE)
                 << "Unhandled service request [" << request.command()
                 << "] from " << encode_base16(request.origin());
@@ -254,21 +379,290 @@ void request_worker::poll()
     }
     else if (which == wakeup_socket_)
     {
-        // Send queued message.
+        // Queue message for its client.
         czmqpp::message message;
         message.receive(wakeup_socket_);
-        message.send(socket_);
+        handle_dequeued(message);
+        outbound_.enqueue(message);
+    }
+    else if (which == stats_socket_)
+    {
+        serve_stats();
     }
 
+    // Run or shed deferred queries as replies release their classes.
+    scheduler_.update();
+
+    // Send whatever the clients will accept.
+    if (outbound_.pending())
+        outbound_.flush(socket_);
+
     // Publish heartbeat.
     if (now() > deadline_)
     {
         deadline_ = now() + settings_.heartbeat_interval();
         log::debug(LOG_SERVICE) << "Publish service heartbeat";
         publish_heartbeat();
+
+        for (const auto& client: outbound_.depths())
+            log::debug(LOG_SERVICE)
+                << "Outbound queue [" << encode_base16(client.first)
+                << "] messages: " << client.second.messages
+                << " bytes: " << client.second.bytes
+                << " dropped: " << client.second.dropped;
+
+        expire_requests();
+        tracer_.flush();
+        recorder_.flush();
     }
 }
 
+// A client reusing the id of a request that is running or answered is
+// ignored, since the replies could not be told apart and the earlier query
+// would run on outside the concurrency of its class. The earlier reply
+// answers both.
+bool request_worker::duplicate(const incoming_message& request) const
+{
+    const auto it = pending_.find(std::make_pair(request.origin(),
+        request.id()));
+    if (it == pending_.end() || (!it->second.running &&
+        !it->second.answered))
+        return false;
+
+    log::debug(LOG_SERVICE)
+        << "Ignored duplicate request [" << request.command() << "] id "
+        << request.id() << " from " << encode_base16(request.origin());
+    return true;
+}
+
+void request_worker::submit(const incoming_message& request,
+    const command& handler)
+{
+    if (duplicate(request))
+        return;
+
+    // The time deferred by the scheduler is timed as the queue stage.
+    const auto timing = stats_.receive(*handler.stats,
+        request.data().size());
+
+    scheduler_.submit(handler.type, request.origin(),
+        std::bind(&request_worker::dispatch,
+            this, request, std::cref(handler), timing),
+        std::bind(&request_worker::shed,
+            this, request, std::cref(handler), timing));
+}
+
+void request_worker::dispatch(const incoming_message& request,
+    const command& handler, statistics::request::ptr timing)
+{
+    // A duplicate deferred while its original was dispatched.
+    if (duplicate(request))
+    {
+        scheduler_.release(handler.type);
+        return;
+    }
+
+    const reply_tracker tracker;
+    handler.handler(request,
+        tracker.wrap(admit(request, handler, timing, true)));
+
+    // Handlers drop invalid requests without a reply, which would otherwise
+    // hold the concurrency of the class until the running expiry.
+    if (tracker.abandoned())
+        abandon(std::make_pair(request.origin(), request.id()));
+}
+
+void request_worker::abandon(const request_key& key)
+{
+    const auto pending = pending_.find(key);
+    if (pending == pending_.end())
+        return;
+
+    release(pending->second);
+    if (pending->second.trace)
+        tracer_.write(*pending->second.trace);
+
+    stats_.unanswered();
+    pending_.erase(pending);
+}
+
+void request_worker::shed(const incoming_message& request,
+    const command& handler, statistics::request::ptr timing)
+{
+    if (duplicate(request))
+        return;
+
+    if (logger_.sampled(request))
+        logger_.log(request_logger::event::shed, *handler.name, request);
+
+    // error_code (4)
+    data_chunk result(4);
+    auto serial = make_serializer(result.begin());
+    write_error_code(serial, error::pool_filled);
+    const auto reply = admit(request, handler, timing, false);
+    reply(outgoing_message(request, result));
+}
+
+queue_send_callback request_worker::admit(const incoming_message& request,
+    const command& handler, statistics::request::ptr timing, bool running)
+{
+    const auto& trace = request.trace();
+    const auto key = std::make_pair(request.origin(), request.id());
+
+    // A client may reuse the id of a request that expired unanswered, and
+    // a shed request is answered here.
+    pending_[key] = { timing, trace, handler.type, running, !running };
+
+    stats_.dispatch(*timing);
+    request.stamp(request_trace::point::dispatch);
+
+    const auto logger = logger_.sampled(request) ? &logger_ : nullptr;
+    const auto origin = logger == nullptr ? data_chunk() : request.origin();
+    const auto name = handler.name;
+
+    // The reply may be sent from any thread.
+    auto& stats = stats_;
+    auto& sender = sender_;
+    return [&stats, &sender, timing, trace, logger, origin, name](
+        const outgoing_message& message)
+    {
+        if (trace)
+            trace->stamp(request_trace::point::reply);
+
+        if (logger != nullptr)
+            logger->log(*name, origin, message);
+
+        stats.reply(*timing, message);
+        sender.queue_send(message);
+    };
+}
+
+void request_worker::release(pending_request& pending)
+{
+    if (!pending.running)
+        return;
+
+    pending.running = false;
+    scheduler_.release(pending.type);
+}
+
+// Parse the reply destination and request id of a fully-framed message.
+static bool parse_key(const czmqpp::message& message, data_chunk& origin,
+    uint32_t& id)
+{
+    // [ DESTINATION ] (optional) [ COMMAND ] [ ID ] [ DATA ]
+    const auto& parts = message.parts();
+    if (parts.size() != 3 && parts.size() != 4)
+        return false;
+
+    auto it = parts.begin();
+    origin = parts.size() == 4 ? *it++ : data_chunk();
+    const auto& raw_id = *++it;
+    if (raw_id.size() != sizeof(uint32_t))
+        return false;
+
+    id = from_little_endian_unsafe<uint32_t>(raw_id.begin());
+    return true;
+}
+
+void request_worker::handle_dequeued(const czmqpp::message& message)
+{
+    uint32_t id;
+    data_chunk origin;
+    if (!parse_key(message, origin, id))
+        return;
+
+    const auto pending = pending_.find(std::make_pair(origin, id));
+    if (pending == pending_.end())
+        return;
+
+    if (pending->second.trace)
+        pending->second.trace->stamp(request_trace::point::dequeue);
+
+    // The first reply completes the query.
+    pending->second.answered = true;
+    release(pending->second);
+}
+
+void request_worker::handle_sent(const czmqpp::message& message)
+{
+    uint32_t id;
+    data_chunk origin;
+    if (!parse_key(message, origin, id))
+        return;
+
+    const auto pending = pending_.find(std::make_pair(origin, id));
+    if (pending == pending_.end())
+        return;
+
+    release(pending->second);
+    stats_.sent(*pending->second.timing);
+
+    const auto& trace = pending->second.trace;
+    if (trace)
+    {
+        trace->stamp(request_trace::point::send);
+        tracer_.write(*trace);
+    }
+
+    pending_.erase(pending);
+}
+
+void request_worker::expire_requests()
+{
+    const auto expiry = statistics::clock::now() - request_expiry;
+    const auto running = statistics::clock::now() - running_expiry;
+    for (auto it = pending_.begin(); it != pending_.end();)
+    {
+        auto& pending = it->second;
+        if (pending.timing->dispatched < running)
+            release(pending);
+
+        if (pending.timing->received < expiry)
+        {
+            if (pending.trace)
+                tracer_.write(*pending.trace);
+
+            stats_.unanswered();
+            it = pending_.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+}
+
+// A minimal HTTP responder, any request on a connection gets the statistics
+// as text and the connection is closed.
+void request_worker::serve_stats()
+{
+    // [ IDENTITY ] [ DATA ], with empty data on connect and disconnect.
+    czmqpp::message request;
+    request.receive(stats_socket_);
+    const auto& parts = request.parts();
+    if (parts.size() != 2 || parts.back().empty())
+        return;
+
+    const auto& identity = parts.front();
+    const auto body = stats_.to_text();
+    const auto response =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    czmqpp::message reply;
+    reply.append(identity);
+    reply.append(data_chunk(response.begin(), response.end()));
+    reply.send(stats_socket_);
+
+    // An empty frame closes the connection.
+    czmqpp::message close;
+    close.append(identity);
+    close.append(data_chunk());
+    close.send(stats_socket_);
+}
+
 void request_worker::publish_heartbeat()
 {
     static uint32_t counter = 0;
@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+namespace bench {
+
+typedef std::chrono::steady_clock clock;
+
+// Calibration stops doubling at this many iterations.
+static constexpr size_t maximum_iterations = 1 << 30;
+
+static double time(operation& measure, size_t iterations)
+{
+    const auto start = clock::now();
+    measure(iterations);
+    const auto elapsed = clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+runner::runner(const options& settings, std::ostream& output)
+  : settings_(settings), output_(output)
+{
+    output_ << "# benchmark\tparameter\tns_per_op\titerations" << std::endl;
+}
+
+bool runner::enabled(const std::string& name) const
+{
+    return name.find(settings_.filter) != std::string::npos;
+}
+
+void runner::run(const std::string& name, uint64_t parameter,
+    operation measure)
+{
+    if (!enabled(name))
+        return;
+
+    // Double the iterations until a run takes a tenth of the target, then
+    // scale to the target.
+    const auto target = settings_.milliseconds * 1e6;
+    size_t iterations = 1;
+    auto elapsed = time(measure, iterations);
+    while (elapsed < target / 10 && iterations < maximum_iterations)
+    {
+        iterations *= 2;
+        elapsed = time(measure, iterations);
+    }
+
+    const auto scaled = static_cast<size_t>(iterations * target / elapsed);
+    iterations = std::max(scaled, size_t(1));
+
+    std::vector<double> samples;
+    for (uint32_t repetition = 0; repetition < settings_.repetitions;
+        ++repetition)
+        samples.push_back(time(measure, iterations) / iterations);
+
+    std::sort(samples.begin(), samples.end());
+    const auto median = samples.empty() ? elapsed / iterations :
+        samples[samples.size() / 2];
+
+    results_.push_back({ name, parameter, iterations, median });
+    output_ << name << "\t" << parameter << "\t" << std::fixed
+        << std::setprecision(1) << median << "\t" << iterations << std::endl;
+}
+
+const std::vector<result>& runner::results() const
+{
+    return results_;
+}
+
+const options& runner::settings() const
+{
+    return settings_;
+}
+
+bool read_baseline(const std::string& path, baseline& out)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string name;
+        uint64_t parameter;
+        double nanoseconds;
+        if (fields >> name >> parameter >> nanoseconds)
+            out[{ name, parameter }] = nanoseconds;
+    }
+
+    // An empty baseline would pass every run.
+    return !out.empty();
+}
+
+bool compare(const std::vector<result>& results, const baseline& expected,
+    double tolerance, std::ostream& output)
+{
+    auto passed = true;
+    output << std::left << std::setw(40) << "benchmark" << std::right
+        << std::setw(10) << "parameter" << std::setw(14) << "baseline"
+        << std::setw(14) << "ns_per_op" << std::setw(9) << "change"
+        << std::endl;
+
+    for (const auto& result: results)
+    {
+        output << std::left << std::setw(40) << result.name << std::right
+            << std::setw(10) << result.parameter << std::fixed
+            << std::setprecision(1);
+
+        const auto it = expected.find({ result.name, result.parameter });
+        if (it == expected.end())
+        {
+            output << std::setw(14) << "-" << std::setw(14)
+                << result.nanoseconds << std::setw(9) << "new" << std::endl;
+            continue;
+        }
+
+        const auto ratio = result.nanoseconds / it->second;
+        const auto slower = ratio > 1 + tolerance;
+        passed &= !slower;
+
+        std::ostringstream change;
+        change << std::showpos << std::fixed << std::setprecision(1)
+            << (ratio - 1) * 100 << "%";
+
+        output << std::setw(14) << it->second << std::setw(14)
+            << result.nanoseconds << std::setw(9) << change.str()
+            << (slower ? "  REGRESSION" : "") << std::endl;
+    }
+
+    return passed;
+}
+
+static std::atomic<size_t> consumed(0);
+
+void consume(size_t value)
+{
+    consumed.fetch_add(value, std::memory_order_relaxed);
+}
+
+queue_send_callback sink()
+{
+    return [](const outgoing_message& response)
+    {
+        consume(response.data().size());
+    };
+}
+
+// Requests can only be read from a socket, so each is sent over inproc. The
+// sockets are kept for the life of the process, for bulk setup.
+incoming_message make_request(const std::string& command,
+    const data_chunk& data)
+{
+    static czmqpp::context context;
+    static czmqpp::socket router(context, ZMQ_ROUTER);
+    static czmqpp::socket dealer(context, ZMQ_DEALER);
+    static const auto bound = router.bind("inproc://bench_request") != -1 &&
+        dealer.connect("inproc://bench_request") != -1;
+    BITCOIN_ASSERT(bound);
+
+    const outgoing_message message(data_chunk(), command, data);
+    message.send(dealer);
+
+    incoming_message request;
+    DEBUG_ONLY(const auto received =) request.recv(router);
+    BITCOIN_ASSERT(received);
+    return request;
+}
+
+} // namespace bench
+} // namespace server
+} // namespace libbitcoin
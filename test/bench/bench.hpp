@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_BENCH_HPP
+#define LIBBITCOIN_SERVER_BENCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+namespace bench {
+
+/// Runs the measured operation the given number of times.
+typedef std::function<void (size_t iterations)> operation;
+
+struct options
+{
+    /// The time to spend measuring each repetition of a benchmark.
+    uint32_t milliseconds = 200;
+
+    /// The repetitions of each benchmark, of which the median is taken.
+    uint32_t repetitions = 5;
+
+    /// The largest subscription count for subscribe_manager benchmarks.
+    uint64_t maximum_subscriptions = 10000000;
+
+    /// Only benchmarks with names containing this are run.
+    std::string filter;
+};
+
+struct result
+{
+    std::string name;
+    uint64_t parameter;
+    uint64_t iterations;
+    double nanoseconds;
+};
+
+/**
+ * Times operations and writes one tab separated line per benchmark:
+ * name, parameter (the size of the synthetic input), nanoseconds per
+ * operation and iterations per repetition. Lines starting with '#' are
+ * comments, so the output can be checked in as a baseline.
+ */
+class runner
+{
+public:
+    runner(const options& settings, std::ostream& output);
+
+    /// False if the benchmark is excluded by the filter.
+    bool enabled(const std::string& name) const;
+
+    void run(const std::string& name, uint64_t parameter, operation measure);
+
+    const std::vector<result>& results() const;
+    const options& settings() const;
+
+private:
+    const options settings_;
+    std::ostream& output_;
+    std::vector<result> results_;
+};
+
+typedef std::map<std::pair<std::string, uint64_t>, double> baseline;
+
+/// Read results written by a runner, false if the file cannot be read or
+/// has no results.
+bool read_baseline(const std::string& path, baseline& out);
+
+/**
+ * Report each result against the baseline, returning false if any is
+ * slower than the baseline by more than the tolerance (a fraction).
+ * Benchmarks missing from the baseline are reported but do not fail.
+ */
+bool compare(const std::vector<result>& results, const baseline& expected,
+    double tolerance, std::ostream& output);
+
+/// Consume a value so that the work producing it is not optimized away.
+void consume(size_t value);
+
+/// A queue_send_callback that consumes the size of each message.
+queue_send_callback sink();
+
+/// Build a request as the worker would receive it from a client.
+incoming_message make_request(const std::string& command,
+    const data_chunk& data);
+
+// The benchmark groups.
+void responses(runner& bench);
+void messages(runner& bench);
+void subscriptions(runner& bench);
+
+} // namespace bench
+} // namespace server
+} // namespace libbitcoin
+
+#endif
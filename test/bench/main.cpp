@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <bitcoin/server.hpp>
+
+BC_USE_LIBBITCOIN_MAIN
+
+using namespace bc::server;
+
+#define BS_BENCH_USAGE \
+    "Usage: libbitcoin_server_bench [options]\n" \
+    "Writes tab separated results to standard output.\n\n" \
+    "  -b <baseline>     Compare with a baseline, failing on a regression.\n" \
+    "  -t <percent>      The allowed regression, defaults to 15.\n" \
+    "  -f <filter>       Run only benchmarks with names containing this.\n" \
+    "  -m <ms>           The time of each repetition, defaults to 200.\n" \
+    "  -r <repetitions>  The repetitions, of which the median is taken,\n" \
+    "                    defaults to 5.\n" \
+    "  -s <count>        The largest subscription count, defaults to " \
+        "10000000.\n"
+
+struct bench_arguments
+{
+    bench::options options;
+    std::string baseline;
+    double tolerance = 15;
+};
+
+static bool parse(int argc, char* argv[], bench_arguments& out)
+{
+    for (auto arg = 1; arg < argc; ++arg)
+    {
+        const std::string option(argv[arg]);
+        if (arg + 1 >= argc)
+            return false;
+
+        const std::string value(argv[++arg]);
+        if (option == "-b")
+            out.baseline = value;
+        else if (option == "-t")
+            out.tolerance = std::atof(value.c_str());
+        else if (option == "-f")
+            out.options.filter = value;
+        else if (option == "-m")
+            out.options.milliseconds = std::atoi(value.c_str());
+        else if (option == "-r")
+            out.options.repetitions = std::atoi(value.c_str());
+        else if (option == "-s")
+            out.options.maximum_subscriptions = std::atoll(value.c_str());
+        else
+            return false;
+    }
+
+    return out.options.milliseconds > 0 && out.tolerance >= 0;
+}
+
+/**
+ * Run the microbenchmarks on synthetic data and optionally compare them
+ * with a baseline written by an earlier run.
+ * @param argc  The number of elements in the argv array.
+ * @param argv  The array of arguments, including the process.
+ * @return      The numeric result to return via console exit.
+ */
+int bc::main(int argc, char* argv[])
+{
+    bc::set_utf8_stdio();
+
+    bench_arguments arguments;
+    if (!parse(argc, argv, arguments))
+    {
+        bc::cerr << BS_BENCH_USAGE;
+        return console_result::failure;
+    }
+
+    bench::baseline expected;
+    if (!arguments.baseline.empty() &&
+        !bench::read_baseline(arguments.baseline, expected))
+    {
+        bc::cerr << "Failed to read results from baseline "
+            << arguments.baseline << ", write it with 'make bench-baseline'."
+            << std::endl;
+        return console_result::failure;
+    }
+
+    bench::runner runner(arguments.options, bc::cout);
+    bench::responses(runner);
+    bench::messages(runner);
+    bench::subscriptions(runner);
+
+    if (arguments.baseline.empty())
+        return console_result::okay;
+
+    bc::cerr << std::endl;
+    const auto passed = bench::compare(runner.results(), expected,
+        arguments.tolerance / 100, bc::cerr);
+    return passed ? console_result::okay : console_result::failure;
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <cstddef>
+#include <string>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+namespace bench {
+
+static const size_t data_sizes[] = { 0, 1024, 65536 };
+static const std::string command = "address.fetch_history2";
+static const std::string endpoint = "inproc://bench_messages";
+
+// The client side of each benchmark is a raw czmqpp message, so the time is
+// that of the server side plus a constant inproc transfer.
+void messages(runner& bench)
+{
+    czmqpp::context context;
+    czmqpp::socket router(context, ZMQ_ROUTER);
+    czmqpp::socket dealer(context, ZMQ_DEALER);
+    DEBUG_ONLY(const auto bound =) router.bind(endpoint);
+    DEBUG_ONLY(const auto connected =) dealer.connect(endpoint);
+    BITCOIN_ASSERT(bound != -1 && connected != -1);
+
+    for (const auto size: data_sizes)
+    {
+        const data_chunk data(size, 0x42);
+        const auto raw_id = to_chunk(to_little_endian(uint32_t(42)));
+        const data_chunk raw_command(command.begin(), command.end());
+
+        bench.run("incoming_message::recv", size,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                {
+                    czmqpp::message message;
+                    message.append(raw_command);
+                    message.append(raw_id);
+                    message.append(data);
+                    message.send(dealer);
+
+                    incoming_message request;
+                    request.recv(router);
+                    consume(request.data().size());
+                }
+            });
+
+        // The reply is addressed to the dealer by its routing identity.
+        const outgoing_message message(data_chunk(), command, data_chunk());
+        message.send(dealer);
+        incoming_message request;
+        request.recv(router);
+        const outgoing_message response(request, data);
+
+        bench.run("outgoing_message::send", size,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                {
+                    response.send(router);
+
+                    czmqpp::message reply;
+                    reply.receive(dealer);
+                    consume(reply.parts().size());
+                }
+            });
+    }
+
+    dealer.destroy(context);
+    router.destroy(context);
+}
+
+} // namespace bench
+} // namespace server
+} // namespace libbitcoin
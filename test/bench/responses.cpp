@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+namespace bench {
+
+using namespace bc::blockchain;
+using namespace bc::chain;
+
+static const size_t history_sizes[] = { 10, 100, 1000, 10000 };
+static const size_t stealth_sizes[] = { 10, 1000, 100000 };
+static const size_t transaction_sizes[] = { 1, 10, 100 };
+
+template <typename Array>
+static void fill(Array& out, std::mt19937_64& random)
+{
+    for (auto& byte: out)
+        byte = static_cast<uint8_t>(random());
+}
+
+// Outputs to one address, every other one spent, in height order as the
+// database returns them.
+static block_chain::history make_history(size_t rows)
+{
+    std::mt19937_64 random(rows);
+    block_chain::history history;
+    uint64_t height = 100000;
+    size_t outputs = 0;
+
+    while (history.size() < rows)
+    {
+        block_chain::history_row output;
+        output.kind = block_chain::point_kind::output;
+        fill(output.point.hash, random);
+        output.point.index = random() % 4;
+        output.height = height++;
+        output.value = random() % 100000000;
+        history.push_back(output);
+
+        if (outputs++ % 2 == 1 || history.size() == rows)
+            continue;
+
+        block_chain::history_row spend;
+        spend.kind = block_chain::point_kind::spend;
+        fill(spend.point.hash, random);
+        spend.point.index = random() % 4;
+        spend.height = height++;
+        spend.previous_checksum = block_chain::spend_checksum(output.point);
+        history.push_back(spend);
+    }
+
+    return history;
+}
+
+static block_chain::stealth make_stealth(size_t rows)
+{
+    std::mt19937_64 random(rows);
+    block_chain::stealth stealth(rows);
+    for (auto& row: stealth)
+    {
+        fill(row.ephemkey, random);
+        fill(row.address, random);
+        fill(row.transaction_hash, random);
+    }
+
+    return stealth;
+}
+
+// Pay to key hash inputs and outputs, with signature sized pushes.
+static transaction make_transaction(size_t puts)
+{
+    std::mt19937_64 random(puts);
+    transaction tx;
+    tx.version = 1;
+    tx.locktime = 0;
+
+    for (size_t index = 0; index < puts; ++index)
+    {
+        transaction_input input;
+        fill(input.previous_output.hash, random);
+        input.previous_output.index = random() % 4;
+        input.script.operations.push_back({ opcode::special,
+            data_chunk(72, 0x30) });
+        input.script.operations.push_back({ opcode::special,
+            data_chunk(33, 0x02) });
+        input.sequence = max_uint32;
+        tx.inputs.push_back(input);
+
+        short_hash hash;
+        fill(hash, random);
+        transaction_output output;
+        output.value = random() % 100000000;
+        output.script.operations = operation::to_pay_key_hash_pattern(hash);
+        tx.outputs.push_back(output);
+    }
+
+    return tx;
+}
+
+void responses(runner& bench)
+{
+    const auto queue_send = sink();
+    const auto history_request = make_request("address.fetch_history2",
+        data_chunk(1 + short_hash_size + 4));
+    const auto compat_request = make_request("address.fetch_history",
+        data_chunk(1 + short_hash_size + 4));
+
+    for (const auto rows: history_sizes)
+    {
+        const auto history = make_history(rows);
+
+        bench.run("send_history_result", rows,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                    send_history_result(code(), history, history_request,
+                        queue_send);
+            });
+
+        bench.run("COMPAT_send_history_result", rows,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                    COMPAT_send_history_result(code(), history,
+                        compat_request, queue_send, 0);
+            });
+    }
+
+    const auto stealth_request = make_request("blockchain.fetch_stealth",
+        data_chunk(1 + 4 + 4));
+
+    for (const auto rows: stealth_sizes)
+    {
+        const auto stealth = make_stealth(rows);
+
+        bench.run("stealth_fetched", rows,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                    stealth_fetched(code(), stealth, stealth_request,
+                        queue_send);
+            });
+    }
+
+    const auto transaction_request = make_request(
+        "blockchain.fetch_transaction", data_chunk(hash_size));
+
+    for (const auto puts: transaction_sizes)
+    {
+        const auto tx = make_transaction(puts);
+
+        bench.run("transaction_fetched", puts,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                    transaction_fetched(code(), tx, transaction_request,
+                        queue_send);
+            });
+    }
+}
+
+} // namespace bench
+} // namespace server
+} // namespace libbitcoin
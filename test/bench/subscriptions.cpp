@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+namespace bench {
+
+using namespace bc::wallet;
+
+// One in this many subscriptions is to a stealth prefix.
+static constexpr size_t stealth_ratio = 10;
+static constexpr uint8_t stealth_bits = 32;
+
+// Runs the work of the manager synchronously, without its dispatcher.
+class bench_subscribe_manager
+  : public subscribe_manager
+{
+public:
+    bench_subscribe_manager(server_node& node, const settings& settings)
+      : subscribe_manager(node, settings)
+    {
+    }
+
+    using subscribe_manager::do_subscribe;
+    using subscribe_manager::do_submit;
+};
+
+// [ type:1 ][ bitsize:1 ][ blocks ]
+static data_chunk subscribe_data(subscribe_type type, uint8_t bitsize,
+    const data_chunk& blocks)
+{
+    data_chunk data(2 + blocks.size());
+    auto serial = make_serializer(data.begin());
+    serial.write_byte(type == subscribe_type::address ? 0 : 1);
+    serial.write_byte(bitsize);
+    serial.write_data(blocks);
+    return data;
+}
+
+static data_chunk random_blocks(size_t size, std::mt19937_64& random)
+{
+    data_chunk blocks(size);
+    for (auto& byte: blocks)
+        byte = static_cast<uint8_t>(random());
+
+    return blocks;
+}
+
+// A typical two in, two out transaction with one stealth output.
+static transaction_analysis::ptr make_analysis(std::mt19937_64& random)
+{
+    const auto analysis = std::make_shared<transaction_analysis>();
+    analysis->data = random_blocks(374, random);
+
+    for (auto count = 0; count < 2; ++count)
+    {
+        short_hash input;
+        short_hash output;
+        const auto input_blocks = random_blocks(short_hash_size, random);
+        const auto output_blocks = random_blocks(short_hash_size, random);
+        std::copy(input_blocks.begin(), input_blocks.end(), input.begin());
+        std::copy(output_blocks.begin(), output_blocks.end(), output.begin());
+        analysis->input_addresses.emplace_back(input, 0x00);
+        analysis->output_addresses.emplace_back(output, 0x00);
+    }
+
+    analysis->stealth_prefixes.push_back(static_cast<uint32_t>(random()));
+    return analysis;
+}
+
+// Matching is a scan of all subscriptions for each address and prefix of
+// the transaction, so the subscription count is the parameter. One address
+// of the transaction is subscribed, so one update is sent per submit.
+void subscriptions(runner& bench)
+{
+    if (!bench.enabled("subscribe_manager::do_submit"))
+        return;
+
+    auto settings = server_node::defaults.server;
+    settings.subscription_limit = std::numeric_limits<uint32_t>::max();
+
+    server_node node;
+    bench_subscribe_manager manager(node, settings);
+    const auto queue_send = sink();
+    std::mt19937_64 random(42);
+
+    const auto tx = make_analysis(random);
+    const auto& subscribed = tx->output_addresses.front().hash();
+    const data_chunk subscribed_blocks(subscribed.begin(), subscribed.end());
+    manager.do_subscribe(make_request("address.subscribe",
+        subscribe_data(subscribe_type::address, 160, subscribed_blocks)),
+        queue_send);
+
+    uint64_t total = 1;
+    for (uint64_t count = 1000;
+        count <= bench.settings().maximum_subscriptions; count *= 10)
+    {
+        for (; total < count; ++total)
+        {
+            const auto stealth = total % stealth_ratio == 0;
+            const auto data = stealth ?
+                subscribe_data(subscribe_type::stealth, stealth_bits,
+                    random_blocks(stealth_bits / 8, random)) :
+                subscribe_data(subscribe_type::address, 160,
+                    random_blocks(short_hash_size, random));
+
+            manager.do_subscribe(make_request("address.subscribe", data),
+                queue_send);
+        }
+
+        // Height zero is a memory pool transaction, which skips the sweep.
+        bench.run("subscribe_manager::do_submit", count,
+            [&](size_t iterations)
+            {
+                for (size_t it = 0; it < iterations; ++it)
+                    manager.do_submit(0, null_hash, tx);
+            });
+    }
+}
+
+} // namespace bench
+} // namespace server
+} // namespace libbitcoin
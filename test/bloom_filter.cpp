@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+// Inserted keys are even and probed absent keys are odd.
+static data_chunk make_key(uint32_t value)
+{
+    return to_chunk(to_little_endian(value));
+}
+
+BOOST_AUTO_TEST_SUITE(bloom_filter_tests)
+
+BOOST_AUTO_TEST_CASE(bloom_filter__construct__zero_elements__disabled)
+{
+    bloom_filter filter(0, 0.01);
+    BOOST_REQUIRE(!filter.enabled());
+    BOOST_REQUIRE_EQUAL(filter.size_bytes(), 0u);
+    BOOST_REQUIRE_EQUAL(filter.false_positive_rate(), 1.0);
+
+    // A disabled filter contains everything and counts nothing.
+    filter.insert(make_key(0));
+    BOOST_REQUIRE_EQUAL(filter.inserted(), 0u);
+    BOOST_REQUIRE(filter.contains(make_key(1)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__empty__false)
+{
+    const bloom_filter filter(1000, 0.01);
+    BOOST_REQUIRE(filter.enabled());
+    for (uint32_t key = 0; key < 1000; ++key)
+        BOOST_REQUIRE(!filter.contains(make_key(key)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__inserted__always_true)
+{
+    const uint32_t elements = 10000;
+    bloom_filter filter(elements, 0.01);
+    for (uint32_t key = 0; key < elements; ++key)
+        filter.insert(make_key(2 * key));
+
+    BOOST_REQUIRE_EQUAL(filter.inserted(), elements);
+    for (uint32_t key = 0; key < elements; ++key)
+        BOOST_REQUIRE(filter.contains(make_key(2 * key)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__construct__target_rate__sized_for_rate)
+{
+    const uint32_t elements = 10000;
+    const auto rate = 0.01;
+    const bloom_filter filter(elements, rate);
+
+    // -ln(p)/ln(2) hashes and -ln(p)/ln(2)^2 bits per element.
+    BOOST_REQUIRE_EQUAL(filter.hash_count(), 7u);
+    BOOST_REQUIRE_GE(filter.size_bytes() * 8, elements * 9.585);
+    BOOST_REQUIRE_LE(filter.size_bytes() * 8, elements * 9.585 * 1.25);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__full__near_target_rate)
+{
+    const uint32_t elements = 10000;
+    const uint32_t probes = 100000;
+    const auto rate = 0.01;
+    bloom_filter filter(elements, rate);
+    for (uint32_t key = 0; key < elements; ++key)
+        filter.insert(make_key(2 * key));
+
+    size_t positives = 0;
+    for (uint32_t key = 0; key < probes; ++key)
+        if (filter.contains(make_key(2 * key + 1)))
+            ++positives;
+
+    // Blocking costs some accuracy, which the sizing is meant to recover.
+    const auto measured = static_cast<double>(positives) / probes;
+    BOOST_REQUIRE_LT(measured, 2 * rate);
+    BOOST_REQUIRE_LT(filter.false_positive_rate(), 2 * rate);
+    BOOST_REQUIRE_GT(filter.false_positive_rate(), rate / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
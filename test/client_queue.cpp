@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <string>
+#include <thread>
+#include <boost/date_time.hpp>
+#include <boost/test/unit_test.hpp>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace boost::posix_time;
+
+static const std::string reply_command = "blockchain.fetch_last_height";
+static const std::string notification_command = "address.update";
+static const std::string endpoint = "inproc://client_queue_test";
+
+static data_chunk to_data(const std::string& text)
+{
+    return data_chunk(text.begin(), text.end());
+}
+
+// [ DESTINATION ] [ COMMAND ] [ ID ] [ DATA ]
+static czmqpp::message make_message(const std::string& destination,
+    const std::string& command, size_t data_size)
+{
+    czmqpp::message message;
+    message.append(to_data(destination));
+    message.append(to_data(command));
+    message.append(data_chunk(4, 0x00));
+    message.append(data_chunk(data_size, 0x00));
+    return message;
+}
+
+static size_t message_size(const std::string& destination,
+    const std::string& command, size_t data_size)
+{
+    return destination.size() + command.size() + 4 + data_size;
+}
+
+static settings queue_settings(uint32_t messages, uint32_t bytes)
+{
+    auto settings = server_node::defaults.server;
+    settings.outbound_queue_messages = messages;
+    settings.outbound_queue_bytes = bytes;
+    settings.slow_client_timeout_seconds = 10;
+    return settings;
+}
+
+static void make_router(czmqpp::socket& router)
+{
+    zsocket_set_router_mandatory(router.self(), 1);
+    zsocket_set_sndtimeo(router.self(), 0);
+    zsocket_set_sndhwm(router.self(), 1);
+    router.set_linger(0);
+}
+
+BOOST_AUTO_TEST_SUITE(client_queue_tests)
+
+BOOST_AUTO_TEST_CASE(client_queue__enqueue__over_message_limit__drops_oldest_notification)
+{
+    const auto settings = queue_settings(2, max_uint32);
+    client_queue queue(settings);
+    queue.enqueue(make_message("client", notification_command, 100));
+    queue.enqueue(make_message("client", notification_command, 10));
+    queue.enqueue(make_message("client", reply_command, 1));
+
+    const auto depths = queue.depths();
+    BOOST_REQUIRE_EQUAL(depths.size(), 1u);
+    const auto& depth = depths.at(to_data("client"));
+    BOOST_REQUIRE_EQUAL(depth.messages, 2u);
+    BOOST_REQUIRE_EQUAL(depth.dropped, 1u);
+    BOOST_REQUIRE_EQUAL(depth.bytes,
+        message_size("client", notification_command, 10) +
+        message_size("client", reply_command, 1));
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__enqueue__over_byte_limit__drops_notifications_only)
+{
+    const auto reply_size = message_size("client", reply_command, 100);
+    const auto settings = queue_settings(max_uint32, reply_size);
+    client_queue queue(settings);
+    queue.enqueue(make_message("client", reply_command, 100));
+    queue.enqueue(make_message("client", notification_command, 100));
+    queue.enqueue(make_message("client", reply_command, 100));
+
+    const auto& depth = queue.depths().at(to_data("client"));
+    BOOST_REQUIRE_EQUAL(depth.messages, 2u);
+    BOOST_REQUIRE_EQUAL(depth.dropped, 1u);
+    BOOST_REQUIRE_EQUAL(depth.bytes, 2 * reply_size);
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__enqueue__replies_over_limit__never_dropped)
+{
+    const auto settings = queue_settings(1, 1);
+    client_queue queue(settings);
+    queue.enqueue(make_message("client", reply_command, 10));
+    queue.enqueue(make_message("client", reply_command, 10));
+    queue.enqueue(make_message("client", reply_command, 10));
+
+    const auto& depth = queue.depths().at(to_data("client"));
+    BOOST_REQUIRE_EQUAL(depth.messages, 3u);
+    BOOST_REQUIRE_EQUAL(depth.dropped, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__enqueue__limits__per_client)
+{
+    const auto settings = queue_settings(1, max_uint32);
+    client_queue queue(settings);
+    queue.enqueue(make_message("first", notification_command, 10));
+    queue.enqueue(make_message("second", notification_command, 10));
+
+    const auto depths = queue.depths();
+    BOOST_REQUIRE_EQUAL(depths.size(), 2u);
+    BOOST_REQUIRE_EQUAL(depths.at(to_data("first")).dropped, 0u);
+    BOOST_REQUIRE_EQUAL(depths.at(to_data("second")).dropped, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__enqueue__no_destination__dropped)
+{
+    const auto settings = queue_settings(10, max_uint32);
+    client_queue queue(settings);
+
+    czmqpp::message unaddressed;
+    unaddressed.append(to_data(reply_command));
+    unaddressed.append(data_chunk(4, 0x00));
+    unaddressed.append(data_chunk(10, 0x00));
+    queue.enqueue(unaddressed);
+    queue.enqueue(make_message("", reply_command, 10));
+
+    BOOST_REQUIRE(!queue.pending());
+    BOOST_REQUIRE(queue.depths().empty());
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__flush__lost_client__disconnected)
+{
+    const auto settings = queue_settings(10, max_uint32);
+    client_queue queue(settings);
+
+    data_chunk disconnected;
+    queue.set_disconnect_handler([&disconnected](const data_chunk& origin)
+    {
+        disconnected = origin;
+    });
+
+    czmqpp::context context;
+    czmqpp::socket router(context, ZMQ_ROUTER);
+    make_router(router);
+    BOOST_REQUIRE_NE(router.bind(endpoint), -1);
+
+    queue.enqueue(make_message("lost", reply_command, 10));
+    queue.flush(router);
+
+    BOOST_REQUIRE(!queue.pending());
+    BOOST_REQUIRE(disconnected == to_data("lost"));
+    router.destroy(context);
+}
+
+BOOST_AUTO_TEST_CASE(client_queue__flush__no_progress_within_timeout__disconnected)
+{
+    auto time = ptime(boost::gregorian::date(2016, 1, 1));
+    const auto settings = queue_settings(max_uint32, max_uint32);
+    client_queue queue(settings, [&time]() { return time; });
+
+    size_t sent = 0;
+    size_t disconnects = 0;
+    queue.set_sent_handler([&sent](const czmqpp::message&) { ++sent; });
+    queue.set_disconnect_handler([&disconnects](const data_chunk&)
+    {
+        ++disconnects;
+    });
+
+    czmqpp::context context;
+    czmqpp::socket router(context, ZMQ_ROUTER);
+    czmqpp::socket dealer(context, ZMQ_DEALER);
+    make_router(router);
+    zsocket_set_identity(dealer.self(), "slow");
+    zsocket_set_rcvhwm(dealer.self(), 1);
+    dealer.set_linger(0);
+    BOOST_REQUIRE_NE(router.bind(endpoint), -1);
+    BOOST_REQUIRE_EQUAL(dealer.connect(endpoint), 0);
+
+    // The router learns the identity of the dealer on connection.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // The dealer never reads, so sends stall once its pipe is full.
+    const size_t count = 100;
+    for (size_t index = 0; index < count; ++index)
+        queue.enqueue(make_message("slow", reply_command, 1000));
+
+    queue.flush(router);
+    BOOST_REQUIRE(sent > 0);
+    BOOST_REQUIRE(sent < count);
+    BOOST_REQUIRE(queue.pending());
+
+    time += seconds(settings.slow_client_timeout_seconds);
+    queue.flush(router);
+    BOOST_REQUIRE(queue.pending());
+    BOOST_REQUIRE_EQUAL(disconnects, 0u);
+
+    time += seconds(1);
+    queue.flush(router);
+    BOOST_REQUIRE(!queue.pending());
+    BOOST_REQUIRE_EQUAL(disconnects, 1u);
+
+    dealer.destroy(context);
+    router.destroy(context);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
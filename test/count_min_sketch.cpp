@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+static data_chunk make_key(uint32_t value)
+{
+    return to_chunk(to_little_endian(value));
+}
+
+BOOST_AUTO_TEST_SUITE(count_min_sketch_tests)
+
+BOOST_AUTO_TEST_CASE(count_min_sketch__estimate__unseen__zero)
+{
+    const count_min_sketch sketch(1024, 4, 0);
+    BOOST_REQUIRE_EQUAL(sketch.estimate(make_key(42)), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(count_min_sketch__increment__wide_sketch__exact)
+{
+    count_min_sketch sketch(4096, 4, 0);
+    const auto key = make_key(42);
+    for (uint32_t count = 1; count <= 10; ++count)
+        BOOST_REQUIRE_EQUAL(sketch.increment(key), count);
+
+    BOOST_REQUIRE_EQUAL(sketch.estimate(key), 10u);
+    BOOST_REQUIRE_EQUAL(sketch.estimate(make_key(43)), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(count_min_sketch__estimate__narrow_sketch__never_undercounts)
+{
+    // Far more keys than counters, so that every counter collides.
+    const uint32_t keys = 1000;
+    count_min_sketch sketch(16, 2, 0);
+    std::vector<uint32_t> counts(keys, 0);
+    for (uint32_t key = 0; key < keys; ++key)
+    {
+        counts[key] = key % 7 + 1;
+        for (uint32_t count = 0; count < counts[key]; ++count)
+            sketch.increment(make_key(key));
+    }
+
+    for (uint32_t key = 0; key < keys; ++key)
+        BOOST_REQUIRE_GE(sketch.estimate(make_key(key)), counts[key]);
+}
+
+BOOST_AUTO_TEST_CASE(count_min_sketch__increment__decay_interval__halves_counts)
+{
+    count_min_sketch sketch(1024, 4, 8);
+    const auto hot = make_key(1);
+    const auto cold = make_key(2);
+
+    for (size_t count = 0; count < 7; ++count)
+    {
+        sketch.increment(hot);
+        BOOST_REQUIRE(!sketch.decayed());
+    }
+
+    BOOST_REQUIRE_EQUAL(sketch.estimate(hot), 7u);
+
+    // The eighth increment halves the counts before counting the key.
+    BOOST_REQUIRE_EQUAL(sketch.increment(cold), 1u);
+    BOOST_REQUIRE(sketch.decayed());
+    BOOST_REQUIRE_EQUAL(sketch.estimate(hot), 3u);
+
+    sketch.increment(cold);
+    BOOST_REQUIRE(!sketch.decayed());
+    BOOST_REQUIRE_EQUAL(sketch.estimate(cold), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(count_min_sketch__increment__zero_decay_interval__never_decays)
+{
+    count_min_sketch sketch(1024, 4, 0);
+    const auto key = make_key(1);
+    for (size_t count = 0; count < 1000; ++count)
+    {
+        sketch.increment(key);
+        BOOST_REQUIRE(!sketch.decayed());
+    }
+
+    BOOST_REQUIRE_EQUAL(sketch.estimate(key), 1000u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+#include "stub/synthetic_chain.hpp"
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::chain;
+using namespace bc::server;
+
+static settings make_settings(bool enabled)
+{
+    auto settings = server_node::defaults.server;
+    settings.header_store_enabled = enabled;
+    return settings;
+}
+
+static synthetic_chain_settings make_chain_settings()
+{
+    synthetic_chain_settings settings;
+    settings.blocks = 0;
+    settings.transactions_per_block = 2;
+    settings.addresses = 100;
+    settings.threads = 2;
+    return settings;
+}
+
+static bool wait_ready(const header_store& store)
+{
+    for (size_t poll = 0; poll < 1000 && !store.ready(); ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return store.ready();
+}
+
+// The serialized headers of the genesis block and the mined blocks.
+static data_chunk serialize(const block_chain::list& mined)
+{
+    auto out = mainnet_genesis_block().header.to_data(false);
+    for (const auto& block: mined)
+        extend_data(out, block->header.to_data(false));
+
+    return out;
+}
+
+// A block linked to the header, in place of the block above it.
+static block_chain::list::value_type make_block(const header& previous,
+    const header& template_header)
+{
+    const auto block = std::make_shared<chain::block>();
+    block->header = template_header;
+    block->header.previous_block_hash = previous.hash();
+    block->header.nonce = template_header.nonce + 1;
+    return block;
+}
+
+BOOST_AUTO_TEST_SUITE(header_store_tests)
+
+BOOST_AUTO_TEST_CASE(header_store__read__disabled__false)
+{
+    synthetic_chain chain(make_chain_settings());
+    header_store store(make_settings(false));
+    store.load(chain);
+
+    data_chunk out;
+    BOOST_REQUIRE(!store.enabled());
+    BOOST_REQUIRE(!store.read(0, 1, out));
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_store__read__not_loaded__false)
+{
+    header_store store(make_settings(true));
+
+    // Until loaded the top of the store is not the top of the chain.
+    data_chunk out;
+    BOOST_REQUIRE(!store.ready());
+    BOOST_REQUIRE(!store.read(0, 1, out));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(header_store__load__several_batches__all_headers)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(1200);
+    header_store store(make_settings(true));
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+    BOOST_REQUIRE_EQUAL(store.size(), 1201u);
+
+    data_chunk out;
+    BOOST_REQUIRE(store.read(0, 1201, out));
+    BOOST_REQUIRE(out == serialize(mined));
+
+    hash_digest hash;
+    BOOST_REQUIRE(store.block_hash(1200, hash));
+    BOOST_REQUIRE(hash == mined.back()->header.hash());
+    BOOST_REQUIRE(!store.block_hash(1201, hash));
+}
+
+BOOST_AUTO_TEST_CASE(header_store__read__beyond_top__truncated)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(10);
+    header_store store(make_settings(true));
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+
+    const auto expected = serialize(mined);
+    const auto size = header_store::header_size;
+
+    data_chunk out;
+    BOOST_REQUIRE(store.read(8, 100, out));
+    BOOST_REQUIRE(out == data_chunk(expected.begin() + 8 * size,
+        expected.end()));
+
+    // The buffer is appended to.
+    data_chunk prefixed(4);
+    BOOST_REQUIRE(store.read(10, 1, prefixed));
+    BOOST_REQUIRE_EQUAL(prefixed.size(), 4 + size);
+
+    // A start above the top is answered empty.
+    out.clear();
+    BOOST_REQUIRE(store.read(11, 1, out));
+    BOOST_REQUIRE(out.empty());
+    BOOST_REQUIRE(store.read(100000, 2000, out));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(header_store__reorganize__linked__replaced)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(10);
+    header_store store(make_settings(true));
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+
+    // Replace blocks 8 to 10 with two blocks forked from block 7.
+    const auto first = make_block(mined[6]->header, mined[7]->header);
+    const auto second = make_block(first->header, mined[8]->header);
+    store.reorganize(7, { first, second });
+    BOOST_REQUIRE_EQUAL(store.size(), 10u);
+
+    hash_digest hash;
+    BOOST_REQUIRE(store.block_hash(8, hash));
+    BOOST_REQUIRE(hash == first->header.hash());
+    BOOST_REQUIRE(store.block_hash(9, hash));
+    BOOST_REQUIRE(hash == second->header.hash());
+    BOOST_REQUIRE(!store.block_hash(10, hash));
+
+    data_chunk out;
+    BOOST_REQUIRE(store.read(7, 3, out));
+    auto expected = mined[6]->header.to_data(false);
+    extend_data(expected, first->header.to_data(false));
+    extend_data(expected, second->header.to_data(false));
+    BOOST_REQUIRE(out == expected);
+}
+
+BOOST_AUTO_TEST_CASE(header_store__reorganize__appended__extended)
+{
+    synthetic_chain chain(make_chain_settings());
+    chain.mine(5);
+    header_store store(make_settings(true));
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+
+    const auto mined = chain.mine(2);
+    store.reorganize(5, mined);
+    BOOST_REQUIRE_EQUAL(store.size(), 8u);
+
+    hash_digest hash;
+    BOOST_REQUIRE(store.block_hash(7, hash));
+    BOOST_REQUIRE(hash == mined.back()->header.hash());
+}
+
+BOOST_AUTO_TEST_CASE(header_store__reorganize__not_linked__drops_below)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(10);
+    header_store store(make_settings(true));
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+
+    // A block that does not link to block 9, which the store has missed a
+    // reorganization of, drops block 9 as well.
+    const auto unlinked = make_block(mined[2]->header, mined[9]->header);
+    store.reorganize(9, { unlinked });
+    BOOST_REQUIRE_EQUAL(store.size(), 9u);
+
+    hash_digest hash;
+    BOOST_REQUIRE(store.block_hash(8, hash));
+    BOOST_REQUIRE(hash == mined[7]->header.hash());
+    BOOST_REQUIRE(!store.block_hash(9, hash));
+}
+
+BOOST_AUTO_TEST_CASE(header_store__reorganize__not_loaded__left_to_walk)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(3);
+    header_store store(make_settings(true));
+
+    store.reorganize(2, { mined.back() });
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+
+    store.load(chain);
+    BOOST_REQUIRE(wait_ready(store));
+    BOOST_REQUIRE_EQUAL(store.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(header_store__destruct__loading__stops)
+{
+    auto chain_settings = make_chain_settings();
+    chain_settings.read_delay_microseconds = 1000;
+    synthetic_chain chain(chain_settings);
+    chain.mine(2000);
+
+    // The walk is still reading headers when the store is destroyed.
+    {
+        header_store store(make_settings(true));
+        store.load(chain);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::server;
+using namespace bc::wallet;
+
+static const auto chain_source = hot_address_cache::source::chain;
+static const auto pool_source = hot_address_cache::source::pool;
+
+static short_hash make_hash(uint8_t value)
+{
+    short_hash hash;
+    hash.fill(value);
+    return hash;
+}
+
+static hot_address_cache::history_ptr make_history()
+{
+    return std::make_shared<const block_chain::history>();
+}
+
+static transaction_analysis paying(const short_hash& hash)
+{
+    transaction_analysis tx;
+    tx.output_addresses.push_back(payment_address(hash, 0x00));
+    return tx;
+}
+
+static transaction_analysis spending(const short_hash& hash)
+{
+    transaction_analysis tx;
+    tx.input_addresses.push_back(payment_address(hash, 0x00));
+    return tx;
+}
+
+// Query the address until it is hot, returns false if it never becomes so.
+static bool heat(hot_address_cache& cache, const short_hash& hash,
+    size_t queries)
+{
+    auto hot = false;
+    for (size_t query = 0; query < queries; ++query)
+        hot = cache.record(hash);
+
+    return hot;
+}
+
+BOOST_AUTO_TEST_SUITE(hot_address_cache_tests)
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__record__zero_capacity__never_hot)
+{
+    hot_address_cache cache(0);
+    BOOST_REQUIRE(!heat(cache, make_hash(1), 100));
+    BOOST_REQUIRE(cache.empty());
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__record__single_query__not_hot)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(!cache.record(hash));
+    BOOST_REQUIRE(cache.empty());
+    BOOST_REQUIRE(cache.record(hash));
+    BOOST_REQUIRE(!cache.empty());
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__record__full__admits_only_hotter)
+{
+    hot_address_cache cache(1);
+    const auto first = make_hash(1);
+    const auto second = make_hash(2);
+    BOOST_REQUIRE(heat(cache, first, 3));
+
+    // Not hotter than the tracked address.
+    BOOST_REQUIRE(!heat(cache, second, 3));
+
+    // Hotter, so it replaces the tracked address.
+    BOOST_REQUIRE(cache.record(second));
+
+    uint64_t generation;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(first, chain_source, out, generation));
+    BOOST_REQUIRE_EQUAL(generation, 0u);
+    BOOST_REQUIRE(!cache.fetch(second, chain_source, out, generation));
+    BOOST_REQUIRE_NE(generation, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__fetch__stored__hit)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(heat(cache, hash, 2));
+
+    uint64_t generation;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    BOOST_REQUIRE_EQUAL(cache.misses(), 1u);
+
+    const auto history = make_history();
+    const data_chunk payload{ 0x01, 0x02 };
+    cache.store(hash, chain_source, generation, history, payload);
+    BOOST_REQUIRE(cache.fetch(hash, chain_source, out, generation));
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1u);
+    BOOST_REQUIRE(out.history == history);
+    BOOST_REQUIRE(out.payload == payload);
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__fetch__other_source__miss)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(heat(cache, hash, 2));
+
+    uint64_t generation;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    cache.store(hash, chain_source, generation, make_history(), data_chunk{ 0x01 });
+    BOOST_REQUIRE(!cache.fetch(hash, pool_source, out, generation));
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__store__invalidated_since_fetch__ignored)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(heat(cache, hash, 2));
+
+    uint64_t stale;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, stale));
+
+    // A transaction arrives while the history is read from the database.
+    cache.invalidate(paying(hash));
+    cache.store(hash, chain_source, stale, make_history(), data_chunk{ 0x01 });
+
+    uint64_t generation;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    BOOST_REQUIRE_NE(generation, stale);
+
+    // A read started after the invalidation is cached.
+    cache.store(hash, chain_source, generation, make_history(), data_chunk{ 0x02 });
+    BOOST_REQUIRE(cache.fetch(hash, chain_source, out, generation));
+    BOOST_REQUIRE(out.payload == data_chunk{ 0x02 });
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__invalidate__spend__clears_all_sources)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(heat(cache, hash, 2));
+
+    uint64_t generation;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    cache.store(hash, chain_source, generation, make_history(), data_chunk{ 0x01 });
+    cache.store(hash, pool_source, generation, make_history(), data_chunk{ 0x01 });
+
+    cache.invalidate(spending(hash));
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    BOOST_REQUIRE(!cache.fetch(hash, pool_source, out, generation));
+}
+
+BOOST_AUTO_TEST_CASE(hot_address_cache__invalidate__other_address__retained)
+{
+    hot_address_cache cache(10);
+    const auto hash = make_hash(1);
+    BOOST_REQUIRE(heat(cache, hash, 2));
+
+    uint64_t generation;
+    hot_address_cache::result out;
+    BOOST_REQUIRE(!cache.fetch(hash, chain_source, out, generation));
+    cache.store(hash, chain_source, generation, make_history(), data_chunk{ 0x01 });
+
+    cache.invalidate(paying(make_hash(2)));
+    BOOST_REQUIRE(cache.fetch(hash, chain_source, out, generation));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
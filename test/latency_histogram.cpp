@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc::server;
+
+// The upper bound of the bucket of the value, read as the median of the
+// value and a larger one, which is not limited by the maximum.
+static uint64_t bucket_upper(uint64_t value)
+{
+    latency_histogram histogram;
+    histogram.record(value);
+    histogram.record(value + 0xffffffffff);
+    return histogram.quantile(0.5);
+}
+
+BOOST_AUTO_TEST_SUITE(latency_histogram_tests)
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__empty__zero)
+{
+    latency_histogram histogram;
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.5), 0u);
+    BOOST_REQUIRE_EQUAL(histogram.count(), 0u);
+    BOOST_REQUIRE_EQUAL(histogram.sum(), 0u);
+    BOOST_REQUIRE_EQUAL(histogram.maximum(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__linear_range__exact)
+{
+    BOOST_REQUIRE_EQUAL(bucket_upper(0), 0u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(1), 1u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(64), 64u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(127), 127u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__above_linear_range__bucket_upper)
+{
+    // [128, 130) is the first bucket of width two, continuing the linear
+    // range without a gap.
+    BOOST_REQUIRE_EQUAL(bucket_upper(128), 129u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(129), 129u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(130), 131u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(255), 255u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(256), 259u);
+
+    // [1000, 1008) has a width of 8.
+    BOOST_REQUIRE_EQUAL(bucket_upper(1000), 1007u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(1007), 1007u);
+    BOOST_REQUIRE_EQUAL(bucket_upper(1008), 1015u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__any_value__within_two_percent)
+{
+    for (uint64_t value = 1; value < 0xffffffff; value = value * 3 + 1)
+    {
+        const auto upper = bucket_upper(value);
+        BOOST_REQUIRE_GE(upper, value);
+        BOOST_REQUIRE_LE(upper - value, value / 64);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__above_largest__last_bucket)
+{
+    latency_histogram histogram;
+    histogram.record(0xffffffffff);
+    histogram.record(0xffffffffff);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.5), 0xffffffffu);
+    BOOST_REQUIRE_EQUAL(histogram.maximum(), 0xffffffffffu);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__uniform__percentiles)
+{
+    latency_histogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value)
+        histogram.record(value);
+
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.0), 1u);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.5), 50u);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.9), 90u);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(0.99), 99u);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(1.0), 100u);
+    BOOST_REQUIRE_EQUAL(histogram.count(), 100u);
+    BOOST_REQUIRE_EQUAL(histogram.sum(), 5050u);
+    BOOST_REQUIRE_EQUAL(histogram.maximum(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__out_of_range_fraction__clamped)
+{
+    latency_histogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value)
+        histogram.record(value);
+
+    BOOST_REQUIRE_EQUAL(histogram.quantile(-1.0), 1u);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(2.0), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__quantile__top_bucket__limited_to_maximum)
+{
+    // 1000 is in [1000, 1008), the quantile does not exceed the maximum.
+    latency_histogram histogram;
+    histogram.record(1000);
+    BOOST_REQUIRE_EQUAL(histogram.quantile(1.0), 1000u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
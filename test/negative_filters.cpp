@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+#include "stub/synthetic_chain.hpp"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::server;
+using namespace bc::wallet;
+
+static settings make_settings(uint32_t elements)
+{
+    auto settings = server_node::defaults.server;
+    settings.negative_filter_addresses = elements;
+    settings.negative_filter_transactions = elements;
+    settings.negative_filter_spends = elements;
+    settings.negative_filter_false_positive_rate = 0.000001;
+    return settings;
+}
+
+static synthetic_chain_settings make_chain_settings()
+{
+    synthetic_chain_settings settings;
+    settings.blocks = 0;
+    settings.transactions_per_block = 10;
+    settings.addresses = 1000;
+    settings.threads = 1;
+    return settings;
+}
+
+static bool wait_ready(const negative_filters& filters)
+{
+    for (size_t poll = 0; poll < 1000 && !filters.ready(); ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return filters.ready();
+}
+
+static hash_digest make_hash(uint8_t fill)
+{
+    hash_digest hash;
+    hash.fill(fill);
+    return hash;
+}
+
+static short_hash make_address(uint8_t fill)
+{
+    short_hash hash;
+    hash.fill(fill);
+    return hash;
+}
+
+static output_point make_point(uint8_t fill, uint32_t index)
+{
+    output_point point;
+    point.hash = make_hash(fill);
+    point.index = index;
+    return point;
+}
+
+BOOST_AUTO_TEST_SUITE(negative_filters_tests)
+
+BOOST_AUTO_TEST_CASE(negative_filters__enabled__zero_elements__false)
+{
+    negative_filters filters(make_settings(0));
+    BOOST_REQUIRE(!filters.enabled());
+    BOOST_REQUIRE(filters.may_have_transaction(make_hash(0x42)));
+    BOOST_REQUIRE(filters.may_have_history(make_address(0x42)));
+    BOOST_REQUIRE(filters.may_be_spent(make_point(0x42, 0)));
+    BOOST_REQUIRE_EQUAL(filters.negatives(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(negative_filters__found__not_ready__true)
+{
+    negative_filters filters(make_settings(10000));
+    BOOST_REQUIRE(filters.enabled());
+    BOOST_REQUIRE(!filters.ready());
+
+    // Absence is not reported until the chain walk completes.
+    BOOST_REQUIRE(filters.may_have_transaction(make_hash(0x42)));
+    BOOST_REQUIRE(filters.may_have_history(make_address(0x42)));
+    BOOST_REQUIRE(filters.may_be_spent(make_point(0x42, 0)));
+    BOOST_REQUIRE_EQUAL(filters.negatives(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(negative_filters__found__loaded__chain_keys_only)
+{
+    synthetic_chain chain(make_chain_settings());
+    const auto mined = chain.mine(20);
+    negative_filters filters(make_settings(10000));
+    filters.load(chain);
+    BOOST_REQUIRE(wait_ready(filters));
+
+    for (const auto& block: mined)
+    {
+        for (const auto& tx: block->transactions)
+        {
+            BOOST_REQUIRE(filters.may_have_transaction(tx.hash()));
+
+            for (const auto& input: tx.inputs)
+                BOOST_REQUIRE(filters.may_be_spent(input.previous_output));
+
+            for (const auto& output: tx.outputs)
+            {
+                const auto address = payment_address::extract(output.script);
+                if (address)
+                    BOOST_REQUIRE(filters.may_have_history(address.hash()));
+            }
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(filters.negatives(), 0u);
+    BOOST_REQUIRE(!filters.may_have_transaction(make_hash(0x42)));
+    BOOST_REQUIRE(!filters.may_have_history(make_address(0x42)));
+    BOOST_REQUIRE(!filters.may_be_spent(make_point(0x42, 7)));
+    BOOST_REQUIRE_EQUAL(filters.negatives(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(negative_filters__insert__pool_transaction__found)
+{
+    synthetic_chain chain(make_chain_settings());
+    chain.mine(5);
+    negative_filters filters(make_settings(10000));
+    filters.load(chain);
+    BOOST_REQUIRE(wait_ready(filters));
+
+    // The transaction spends mined outputs but is not itself mined.
+    const auto tx = chain.make_transaction();
+    const auto hash = tx.hash();
+    BOOST_REQUIRE(!filters.may_have_transaction(hash));
+
+    filters.insert(tx, hash);
+    BOOST_REQUIRE(filters.may_have_transaction(hash));
+    BOOST_REQUIRE(filters.may_be_spent(tx.inputs.front().previous_output));
+}
+
+BOOST_AUTO_TEST_CASE(negative_filters__destruct__loading__stops)
+{
+    auto chain_settings = make_chain_settings();
+    chain_settings.read_delay_microseconds = 1000;
+    synthetic_chain chain(chain_settings);
+    chain.mine(100);
+
+    // The walk is still reading blocks when the filters are destroyed.
+    {
+        negative_filters filters(make_settings(10000));
+        filters.load(chain);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
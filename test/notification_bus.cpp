@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+typedef notification::kind kind;
+typedef notification_bus::wait_strategy wait_strategy;
+typedef notification_bus::overflow_policy overflow_policy;
+
+static notification make_notification(kind type, uint32_t height)
+{
+    notification item;
+    item.type = type;
+    item.height = height;
+    return item;
+}
+
+// Records the heights handled, holding the consumer in the first handler
+// until opened, so that notifications published meanwhile are behind.
+class recorder
+{
+public:
+    recorder()
+      : entered_(false), open_(false)
+    {
+    }
+
+    notification_bus::handler handler()
+    {
+        return [this](const notification& item)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            heights_.push_back(item.height);
+            entered_ = true;
+            changed_.notify_all();
+            changed_.wait(lock, [this]() { return open_; });
+        };
+    }
+
+    void wait_entered()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        BOOST_REQUIRE(changed_.wait_for(lock, std::chrono::seconds(10),
+            [this]() { return entered_; }));
+    }
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        changed_.notify_all();
+    }
+
+    std::vector<uint32_t> heights()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heights_;
+    }
+
+private:
+    bool entered_;
+    bool open_;
+    std::vector<uint32_t> heights_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+};
+
+// Wait until the only consumer has caught up with the producer.
+static notification_bus::consumer_status wait_caught_up(
+    const notification_bus& bus)
+{
+    for (size_t poll = 0; poll < 1000; ++poll)
+    {
+        const auto status = bus.status();
+        BOOST_REQUIRE_EQUAL(status.size(), 1u);
+        if (status.front().lag == 0)
+            return status.front();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    BOOST_FAIL("consumer did not catch up");
+    return bus.status().front();
+}
+
+BOOST_AUTO_TEST_SUITE(notification_bus_tests)
+
+BOOST_AUTO_TEST_CASE(notification_bus__publish__unsubscribed__ignored)
+{
+    notification_bus bus(8);
+    BOOST_REQUIRE(!bus.subscribed());
+    bus.publish(make_notification(kind::block, 0));
+    BOOST_REQUIRE(bus.status().empty());
+    BOOST_REQUIRE_EQUAL(bus.dropped(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(notification_bus__subscribe__later__sees_later_only)
+{
+    notification_bus bus(8);
+    std::atomic<size_t> first(0);
+    const auto id = bus.subscribe("first",
+        [&first](const notification&) { ++first; },
+        wait_strategy::blocking, overflow_policy::drop, 4);
+
+    bus.publish(make_notification(kind::block, 0));
+    wait_caught_up(bus);
+
+    recorder second;
+    second.open();
+    bus.unsubscribe(id);
+    BOOST_REQUIRE(!bus.subscribed());
+    bus.subscribe("second", second.handler(), wait_strategy::yielding,
+        overflow_policy::drop, 4);
+
+    bus.publish(make_notification(kind::block, 1));
+    bus.publish(make_notification(kind::block, 2));
+    wait_caught_up(bus);
+
+    BOOST_REQUIRE_EQUAL(first.load(), 1u);
+    BOOST_REQUIRE(second.heights() == std::vector<uint32_t>({ 1, 2 }));
+    bus.stop();
+}
+
+BOOST_AUTO_TEST_CASE(notification_bus__publish__behind__batched_in_order)
+{
+    notification_bus bus(64);
+    recorder consumer;
+    bus.subscribe("batched", consumer.handler(), wait_strategy::blocking,
+        overflow_policy::drop, 4);
+
+    // The first batch is the one notification published before it.
+    bus.publish(make_notification(kind::block, 0));
+    consumer.wait_entered();
+
+    std::vector<uint32_t> expected{ 0 };
+    for (uint32_t height = 1; height <= 16; ++height)
+    {
+        bus.publish(make_notification(kind::transaction, height));
+        expected.push_back(height);
+    }
+
+    // The cursor is stored once per batch, so all are behind.
+    BOOST_REQUIRE_EQUAL(bus.status().front().lag, 17u);
+
+    consumer.open();
+    const auto status = wait_caught_up(bus);
+    BOOST_REQUIRE_EQUAL(status.processed, 17u);
+    BOOST_REQUIRE_EQUAL(status.batches, 5u);
+    BOOST_REQUIRE_EQUAL(status.dropped, 0u);
+    BOOST_REQUIRE(consumer.heights() == expected);
+    bus.stop();
+}
+
+BOOST_AUTO_TEST_CASE(notification_bus__publish__full_ring__overrun_not_blocked)
+{
+    notification_bus bus(8);
+    recorder consumer;
+    bus.subscribe("stalled", consumer.handler(), wait_strategy::blocking,
+        overflow_policy::drop, 64);
+
+    bus.publish(make_notification(kind::block, 0));
+    consumer.wait_entered();
+
+    // The producer does not wait for the stalled consumer.
+    for (uint32_t height = 1; height <= 20; ++height)
+        bus.publish(make_notification(kind::block, height));
+
+    BOOST_REQUIRE_EQUAL(bus.status().front().lag, 21u);
+
+    // The consumer skips to the oldest notification still in the ring.
+    consumer.open();
+    const auto status = wait_caught_up(bus);
+    BOOST_REQUIRE_EQUAL(status.processed, 9u);
+    BOOST_REQUIRE_EQUAL(status.dropped, 12u);
+    BOOST_REQUIRE_EQUAL(bus.dropped(), 12u);
+    BOOST_REQUIRE(consumer.heights() ==
+        std::vector<uint32_t>({ 0, 13, 14, 15, 16, 17, 18, 19, 20 }));
+    bus.stop();
+}
+
+BOOST_AUTO_TEST_CASE(notification_bus__publish__half_ring_behind__transactions_shed)
+{
+    notification_bus bus(8);
+    recorder consumer;
+    bus.subscribe("shedding", consumer.handler(), wait_strategy::blocking,
+        overflow_policy::shed_transactions, 64);
+
+    bus.publish(make_notification(kind::block, 0));
+    consumer.wait_entered();
+
+    // Transactions more than half a ring behind are shed, blocks are not.
+    bus.publish(make_notification(kind::transaction, 1));
+    bus.publish(make_notification(kind::transaction, 2));
+    bus.publish(make_notification(kind::block, 3));
+    bus.publish(make_notification(kind::transaction, 4));
+    bus.publish(make_notification(kind::transaction, 5));
+    bus.publish(make_notification(kind::disconnect, 6));
+
+    consumer.open();
+    const auto status = wait_caught_up(bus);
+    BOOST_REQUIRE_EQUAL(status.processed, 5u);
+    BOOST_REQUIRE_EQUAL(status.dropped, 2u);
+    BOOST_REQUIRE(consumer.heights() ==
+        std::vector<uint32_t>({ 0, 3, 4, 5, 6 }));
+    bus.stop();
+}
+
+BOOST_AUTO_TEST_CASE(notification_bus__publish__many_producers__each_consumer_all)
+{
+    notification_bus bus(4096);
+    std::atomic<size_t> blocking(0);
+    std::atomic<size_t> yielding(0);
+    bus.subscribe("blocking", [&blocking](const notification&) { ++blocking; },
+        wait_strategy::blocking, overflow_policy::drop, 16);
+    bus.subscribe("yielding", [&yielding](const notification&) { ++yielding; },
+        wait_strategy::yielding, overflow_policy::drop, 16);
+
+    std::vector<std::thread> producers;
+    for (size_t producer = 0; producer < 4; ++producer)
+        producers.emplace_back([&bus]()
+        {
+            for (uint32_t height = 0; height < 500; ++height)
+                bus.publish(make_notification(kind::transaction, height));
+        });
+
+    for (auto& producer: producers)
+        producer.join();
+
+    for (size_t poll = 0; poll < 1000 &&
+        (blocking + yielding < 4000); ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    BOOST_REQUIRE_EQUAL(blocking.load(), 2000u);
+    BOOST_REQUIRE_EQUAL(yielding.load(), 2000u);
+    BOOST_REQUIRE_EQUAL(bus.dropped(), 0u);
+    bus.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+static outgoing_message make_reply()
+{
+    return outgoing_message(data_chunk{ 0x42 }, "address.fetch_history",
+        data_chunk(4));
+}
+
+BOOST_AUTO_TEST_SUITE(reply_tracker_tests)
+
+BOOST_AUTO_TEST_CASE(reply_tracker__abandoned__not_wrapped__true)
+{
+    const reply_tracker tracker;
+    BOOST_REQUIRE(tracker.abandoned());
+}
+
+BOOST_AUTO_TEST_CASE(reply_tracker__abandoned__dropped__true)
+{
+    size_t sent = 0;
+    const reply_tracker tracker;
+
+    // As a handler returning on invalid data without a reply.
+    const auto handler = [](queue_send_callback) {};
+    handler(tracker.wrap([&sent](const outgoing_message&) { ++sent; }));
+
+    BOOST_REQUIRE(tracker.abandoned());
+    BOOST_REQUIRE_EQUAL(sent, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(reply_tracker__abandoned__replied__false)
+{
+    size_t sent = 0;
+    const reply_tracker tracker;
+    const auto handler = [](queue_send_callback reply)
+    {
+        reply(make_reply());
+    };
+
+    handler(tracker.wrap([&sent](const outgoing_message&) { ++sent; }));
+    BOOST_REQUIRE(!tracker.abandoned());
+    BOOST_REQUIRE_EQUAL(sent, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(reply_tracker__abandoned__kept__false_until_released)
+{
+    const reply_tracker tracker;
+    queue_send_callback kept;
+
+    // As a handler keeping the reply for a lookup.
+    const auto handler = [&kept](queue_send_callback reply)
+    {
+        kept = reply;
+    };
+
+    handler(tracker.wrap([](const outgoing_message&) {}));
+    BOOST_REQUIRE(!tracker.abandoned());
+
+    // The lookup failed and was dropped without a reply.
+    kept = nullptr;
+    BOOST_REQUIRE(tracker.abandoned());
+}
+
+BOOST_AUTO_TEST_CASE(reply_tracker__abandoned__replied_on_other_thread__false)
+{
+    const reply_tracker tracker;
+    auto reply = tracker.wrap([](const outgoing_message&) {});
+
+    std::thread lookup([reply]()
+    {
+        reply(make_reply());
+    });
+
+    reply = nullptr;
+    lookup.join();
+    BOOST_REQUIRE(!tracker.abandoned());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
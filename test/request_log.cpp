@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <czmq++/czmqpp.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+static const std::string endpoint = "inproc://request_log_test";
+
+struct request_log_fixture
+{
+    request_log_fixture()
+      : path(boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("request-log-%%%%-%%%%.bsrl")),
+        router(context, ZMQ_ROUTER),
+        dealer(context, ZMQ_DEALER)
+    {
+        router.set_linger(0);
+        dealer.set_linger(0);
+        BOOST_REQUIRE_NE(router.bind(endpoint), -1);
+        BOOST_REQUIRE_NE(dealer.connect(endpoint), -1);
+    }
+
+    ~request_log_fixture()
+    {
+        boost::filesystem::remove(path);
+    }
+
+    // A request received by the server side, as the worker records it.
+    incoming_message receive(const std::string& command,
+        const data_chunk& data)
+    {
+        czmqpp::message message;
+        message.append(data_chunk(command.begin(), command.end()));
+        message.append(to_chunk(to_little_endian(uint32_t(42))));
+        message.append(data);
+        message.send(dealer);
+
+        incoming_message request;
+        request.recv(router);
+        return request;
+    }
+
+    void write_log(const data_chunk& contents) const
+    {
+        std::ofstream file(path.string(), std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char*>(contents.data()),
+            contents.size());
+    }
+
+    const boost::filesystem::path path;
+    czmqpp::context context;
+    czmqpp::socket router;
+    czmqpp::socket dealer;
+};
+
+// The log header, magic and version.
+static data_chunk log_header()
+{
+    return { 'B', 'S', 'R', 'L', 0x01 };
+}
+
+BOOST_FIXTURE_TEST_SUITE(request_log_tests, request_log_fixture)
+
+BOOST_AUTO_TEST_CASE(request_log__read__recorded_field_sizes__round_trip)
+{
+    // Sizes at each boundary of the one, three and five byte encodings.
+    const size_t sizes[] = { 0, 0xfc, 0xfd, 0xffff, 0x10000 };
+    const std::string long_command(0xfd, 'c');
+
+    request_recorder recorder(path);
+    BOOST_REQUIRE(recorder.start());
+
+    for (const auto size: sizes)
+        recorder.record(receive("blockchain.fetch_history",
+            data_chunk(size, 0x42)));
+
+    recorder.record(receive(long_command, data_chunk{ 1, 2, 3 }));
+    BOOST_REQUIRE_EQUAL(recorder.recorded(), 6u);
+    recorder.stop();
+
+    request_log_reader reader(path);
+    BOOST_REQUIRE(reader.valid());
+
+    recorded_request request;
+    uint64_t previous = 0;
+    for (const auto size: sizes)
+    {
+        BOOST_REQUIRE(reader.read(request));
+        BOOST_REQUIRE_EQUAL(request.command, "blockchain.fetch_history");
+        BOOST_REQUIRE(request.data == data_chunk(size, 0x42));
+        BOOST_REQUIRE_GE(request.microseconds, previous);
+        previous = request.microseconds;
+    }
+
+    BOOST_REQUIRE(reader.read(request));
+    BOOST_REQUIRE_EQUAL(request.command, long_command);
+    BOOST_REQUIRE(request.data == (data_chunk{ 1, 2, 3 }));
+    BOOST_REQUIRE(!reader.read(request));
+}
+
+BOOST_AUTO_TEST_CASE(request_log__read__delta_encodings__accumulated)
+{
+    // Deltas in the one, three, five and nine byte encodings.
+    auto contents = log_header();
+    const data_chunk deltas[] =
+    {
+        { 0xfc },
+        { 0xfd, 0x00, 0x01 },
+        { 0xfe, 0x00, 0x00, 0x01, 0x00 },
+        { 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 }
+    };
+
+    for (const auto& delta: deltas)
+    {
+        extend_data(contents, delta);
+        extend_data(contents, data_chunk{ 0x01, 'x', 0x00 });
+    }
+
+    write_log(contents);
+    request_log_reader reader(path);
+    BOOST_REQUIRE(reader.valid());
+
+    const uint64_t expected[] =
+    {
+        0xfc,
+        0xfc + 0x100,
+        0xfc + 0x100 + 0x10000,
+        0xfc + 0x100 + 0x10000 + 0x100000000
+    };
+
+    recorded_request request;
+    for (const auto microseconds: expected)
+    {
+        BOOST_REQUIRE(reader.read(request));
+        BOOST_REQUIRE_EQUAL(request.microseconds, microseconds);
+        BOOST_REQUIRE_EQUAL(request.command, "x");
+        BOOST_REQUIRE(request.data.empty());
+    }
+
+    BOOST_REQUIRE(!reader.read(request));
+}
+
+BOOST_AUTO_TEST_CASE(request_log__read__truncated__false)
+{
+    auto contents = log_header();
+    extend_data(contents, data_chunk{ 0x00, 0x01, 'x', 0x04, 1, 2 });
+    write_log(contents);
+
+    request_log_reader reader(path);
+    BOOST_REQUIRE(reader.valid());
+
+    recorded_request request;
+    BOOST_REQUIRE(!reader.read(request));
+}
+
+BOOST_AUTO_TEST_CASE(request_log__read__oversized_field__false)
+{
+    // A 32MiB + 1 command is taken as a corrupt log, and is not allocated.
+    auto contents = log_header();
+    extend_data(contents, data_chunk{ 0x00, 0xfe, 0x01, 0x00, 0x00, 0x02 });
+    write_log(contents);
+
+    request_log_reader reader(path);
+    BOOST_REQUIRE(reader.valid());
+
+    recorded_request request;
+    BOOST_REQUIRE(!reader.read(request));
+}
+
+BOOST_AUTO_TEST_CASE(request_log__valid__other_version__false)
+{
+    write_log({ 'B', 'S', 'R', 'L', 0x02 });
+    BOOST_REQUIRE(!request_log_reader(path).valid());
+}
+
+BOOST_AUTO_TEST_CASE(request_log__valid__other_magic__false)
+{
+    write_log({ 'B', 'S', 'R', 'X', 0x01 });
+    BOOST_REQUIRE(!request_log_reader(path).valid());
+}
+
+BOOST_AUTO_TEST_CASE(request_log__valid__missing_file__false)
+{
+    BOOST_REQUIRE(!request_log_reader(path).valid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,311 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+typedef request_scheduler::clock scheduler_clock;
+
+static const auto normal = request_class::normal;
+
+static settings make_settings()
+{
+    auto settings = server_node::defaults.server;
+    settings.query_normal_concurrency = 1;
+    settings.query_expensive_concurrency = 1;
+    settings.query_delay_target_milliseconds = 5;
+    settings.query_delay_interval_milliseconds = 100;
+    settings.query_rate_limit = 0;
+    settings.query_rate_burst = 1;
+    settings.query_client_weights.clear();
+    return settings;
+}
+
+static data_chunk make_client(const std::string& identity)
+{
+    return data_chunk(identity.begin(), identity.end());
+}
+
+// The scheduler reads time only from the source, which tests advance.
+class fixture
+{
+public:
+    fixture(const settings& settings)
+      : now_(scheduler_clock::now()),
+        scheduler_(settings, [this]() { return now_; })
+    {
+    }
+
+    request_scheduler& scheduler()
+    {
+        return scheduler_;
+    }
+
+    void advance(size_t milliseconds)
+    {
+        now_ += std::chrono::milliseconds(milliseconds);
+    }
+
+    // Hold the concurrency of the class so that later queries are deferred.
+    void occupy(request_class type)
+    {
+        scheduler_.submit(type, make_client("busy"), []() {}, []() {});
+        BOOST_REQUIRE_EQUAL(scheduler_.running(type), 1u);
+    }
+
+    // Record the client of each query run, completing it immediately
+    // unless held.
+    void submit(request_class type, const std::string& client,
+        bool hold=false)
+    {
+        auto& ran = ran_;
+        auto& shed = shed_;
+        auto& scheduler = scheduler_;
+        scheduler_.submit(type, make_client(client),
+            [&ran, &scheduler, type, client, hold]()
+            {
+                ran.push_back(client);
+                if (!hold)
+                    scheduler.release(type);
+            },
+            [&shed, client]()
+            {
+                shed.push_back(client);
+            });
+    }
+
+    const std::vector<std::string>& ran() const
+    {
+        return ran_;
+    }
+
+    const std::vector<std::string>& shed() const
+    {
+        return shed_;
+    }
+
+private:
+    scheduler_clock::time_point now_;
+    request_scheduler scheduler_;
+    std::vector<std::string> ran_;
+    std::vector<std::string> shed_;
+};
+
+BOOST_AUTO_TEST_SUITE(request_scheduler_tests)
+
+BOOST_AUTO_TEST_CASE(request_scheduler__classify__commands__expected)
+{
+    BOOST_REQUIRE(request_scheduler::classify("blockchain.fetch_last_height") ==
+        request_class::cheap);
+    BOOST_REQUIRE(request_scheduler::classify("address.fetch_history2") ==
+        request_class::expensive);
+    BOOST_REQUIRE(request_scheduler::classify("unknown.command") ==
+        request_class::normal);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__submit__cheap__never_deferred)
+{
+    fixture test(make_settings());
+    test.occupy(normal);
+
+    for (size_t query = 0; query < 10; ++query)
+        test.submit(request_class::cheap, "alice");
+
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 10u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(request_class::cheap), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__submit__over_concurrency__deferred)
+{
+    fixture test(make_settings());
+    test.occupy(normal);
+    test.submit(normal, "alice");
+    test.submit(normal, "alice");
+
+    BOOST_REQUIRE(test.ran().empty());
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(normal), 2u);
+
+    test.scheduler().release(normal);
+    test.scheduler().update();
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 2u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(normal), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().running(normal), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__update__weighted_clients__weighted_share)
+{
+    auto settings = make_settings();
+    settings.query_client_weights = { "alice:3" };
+    fixture test(settings);
+    test.occupy(normal);
+
+    for (size_t query = 0; query < 6; ++query)
+    {
+        test.submit(normal, "alice");
+        test.submit(normal, "bob");
+    }
+
+    test.scheduler().release(normal);
+    test.scheduler().update();
+
+    // Each round runs three of alice's queries to one of bob's.
+    const std::vector<std::string> expected
+    {
+        "alice", "alice", "alice", "bob",
+        "alice", "alice", "alice", "bob",
+        "bob", "bob", "bob", "bob"
+    };
+
+    BOOST_REQUIRE(test.ran() == expected);
+    BOOST_REQUIRE(test.shed().empty());
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__update__equal_clients__alternate)
+{
+    fixture test(make_settings());
+    test.occupy(normal);
+
+    for (size_t query = 0; query < 3; ++query)
+        test.submit(normal, "alice");
+
+    test.submit(normal, "bob");
+    test.scheduler().release(normal);
+    test.scheduler().update();
+
+    const std::vector<std::string> expected
+    {
+        "alice", "bob", "alice", "alice"
+    };
+
+    BOOST_REQUIRE(test.ran() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__update__delay_above_target__shed_after_interval)
+{
+    fixture test(make_settings());
+    test.occupy(normal);
+
+    for (size_t query = 0; query < 3; ++query)
+        test.submit(normal, "alice");
+
+    // Above target, but not yet for an interval.
+    test.advance(10);
+    test.scheduler().update();
+    test.advance(50);
+    test.scheduler().update();
+    BOOST_REQUIRE(test.shed().empty());
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(normal), 3u);
+
+    // The interval has passed, one query is shed from the head.
+    test.advance(51);
+    test.scheduler().update();
+    BOOST_REQUIRE_EQUAL(test.shed().size(), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().shed(normal), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(normal), 2u);
+
+    // The next drop is an interval later while the delay persists.
+    test.advance(50);
+    test.scheduler().update();
+    BOOST_REQUIRE_EQUAL(test.shed().size(), 1u);
+    test.advance(51);
+    test.scheduler().update();
+    BOOST_REQUIRE_EQUAL(test.shed().size(), 2u);
+
+    test.scheduler().release(normal);
+    test.scheduler().update();
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().deferred(normal), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__update__delay_below_target__not_shed)
+{
+    fixture test(make_settings());
+    test.occupy(normal);
+
+    // Each query waits for the one before it, for longer than an interval.
+    for (size_t poll = 0; poll < 100; ++poll)
+    {
+        test.submit(normal, "alice", true);
+        test.advance(4);
+        test.scheduler().release(normal);
+        test.scheduler().update();
+    }
+
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 100u);
+    BOOST_REQUIRE(test.shed().empty());
+    BOOST_REQUIRE_EQUAL(test.scheduler().shed(normal), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__submit__over_rate__limited)
+{
+    auto settings = make_settings();
+    settings.query_rate_limit = 10;
+    settings.query_rate_burst = 2;
+    fixture test(settings);
+
+    // The burst is taken at once, then a query per tenth of a second.
+    for (size_t query = 0; query < 3; ++query)
+        test.submit(request_class::cheap, "alice");
+
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 2u);
+    BOOST_REQUIRE_EQUAL(test.shed().size(), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().limited(), 1u);
+
+    test.advance(100);
+    test.submit(request_class::cheap, "alice");
+    test.submit(request_class::cheap, "alice");
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 3u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().limited(), 2u);
+
+    // Other clients have their own bucket.
+    test.submit(request_class::cheap, "bob");
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(request_scheduler__submit__weighted_over_rate__scaled_limit)
+{
+    auto settings = make_settings();
+    settings.query_rate_limit = 10;
+    settings.query_rate_burst = 2;
+    settings.query_client_weights = { "alice:2" };
+    fixture test(settings);
+
+    for (size_t query = 0; query < 5; ++query)
+        test.submit(request_class::cheap, "alice");
+
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 4u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().limited(), 1u);
+
+    // Twice the rate refills two tokens in a tenth of a second.
+    test.advance(100);
+    for (size_t query = 0; query < 3; ++query)
+        test.submit(request_class::cheap, "alice");
+
+    BOOST_REQUIRE_EQUAL(test.ran().size(), 6u);
+    BOOST_REQUIRE_EQUAL(test.scheduler().limited(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+
+// The key of the SipHash reference vectors, bytes 0x00 to 0x0f.
+static const siphash_key reference_key{ 0x0706050403020100,
+    0x0f0e0d0c0b0a0908 };
+
+// The reference message of the size, bytes 0x00 to size - 1.
+static data_chunk reference_message(size_t size)
+{
+    data_chunk message(size);
+    for (size_t byte = 0; byte < size; ++byte)
+        message[byte] = static_cast<uint8_t>(byte);
+
+    return message;
+}
+
+BOOST_AUTO_TEST_SUITE(siphash_tests)
+
+// Vectors from the SipHash-2-4 reference implementation, read little endian.
+
+BOOST_AUTO_TEST_CASE(siphash__siphash__empty__reference)
+{
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(0)),
+        0x726fdb47dd0e0e31u);
+}
+
+BOOST_AUTO_TEST_CASE(siphash__siphash__partial_word__reference)
+{
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(1)),
+        0x74f839c593dc67fdu);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(2)),
+        0x0d6c8009d9a94f5au);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(3)),
+        0x85676696d7fb7e2du);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(7)),
+        0xab0200f58b01d137u);
+}
+
+BOOST_AUTO_TEST_CASE(siphash__siphash__whole_words__reference)
+{
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(8)),
+        0x93f5f5799a932462u);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(16)),
+        0x3f2acc7f57c29bdbu);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(32)),
+        0x7127512f72f27cceu);
+}
+
+BOOST_AUTO_TEST_CASE(siphash__siphash__words_and_tail__reference)
+{
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(9)),
+        0x9e0082df0ba9e4b0u);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(15)),
+        0xa129ca6149be45e5u);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(17)),
+        0x699ae9f52cbe4794u);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(31)),
+        0x32d892fad841c342u);
+    BOOST_REQUIRE_EQUAL(siphash(reference_key, reference_message(63)),
+        0x958a324ceb064572u);
+}
+
+// The short id of the genesis coinbase in a compact genesis block.
+
+BOOST_AUTO_TEST_CASE(siphash__short_id_key__genesis__expected)
+{
+    const auto header = mainnet_genesis_block().header.to_data(false);
+    BOOST_REQUIRE_EQUAL(header.size(), 80u);
+
+    const auto key = short_id_key(header, 0x0102030405060708);
+    BOOST_REQUIRE_EQUAL(key.k0, 0x9604c091d994cfcau);
+    BOOST_REQUIRE_EQUAL(key.k1, 0x82da4839b1005eb7u);
+}
+
+BOOST_AUTO_TEST_CASE(siphash__short_id__genesis_coinbase__six_bytes)
+{
+    const auto genesis = mainnet_genesis_block();
+    const auto header = genesis.header.to_data(false);
+    const auto tx_hash = genesis.transactions.front().hash();
+    const auto key = short_id_key(header, 0x0102030405060708);
+
+    BOOST_REQUIRE_EQUAL(siphash(key, tx_hash), 0x7171d3dad4322e88u);
+
+    const auto id = short_id(key, tx_hash);
+    BOOST_REQUIRE_EQUAL(id, 0x0000d3dad4322e88u);
+
+    // Serialized as the low 6 bytes, little endian.
+    const auto raw_id = to_little_endian(id);
+    const data_chunk expected{ 0x88, 0x2e, 0x32, 0xd4, 0xda, 0xd3 };
+    BOOST_REQUIRE(data_chunk(raw_id.begin(), raw_id.begin() + 6) ==
+        expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
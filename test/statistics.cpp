@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc::server;
+
+// The metric family of a sample line, without labels or summary suffixes.
+static std::string family(const std::string& line)
+{
+    auto name = line.substr(0, line.find_first_of("{ "));
+    for (const std::string suffix: { "_sum", "_count" })
+        if (name.size() > suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(),
+                suffix) == 0 && name.find("latency_microseconds") !=
+                std::string::npos)
+            name.resize(name.size() - suffix.size());
+
+    return name;
+}
+
+// True if each family is one group of lines led by its type line.
+static bool grouped(const std::string& text)
+{
+    std::set<std::string> seen;
+    std::string current;
+    std::istringstream lines(text);
+
+    for (std::string line; std::getline(lines, line);)
+    {
+        const std::string type = "# TYPE ";
+        if (line.compare(0, type.size(), type) == 0)
+        {
+            current = line.substr(type.size(), line.find(' ', type.size()) -
+                type.size());
+
+            if (!seen.insert(current).second)
+                return false;
+
+            continue;
+        }
+
+        if (line.empty() || family(line) != current)
+            return false;
+    }
+
+    return true;
+}
+
+static bool contains(const std::string& text, const std::string& part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+BOOST_AUTO_TEST_SUITE(statistics_tests)
+
+BOOST_AUTO_TEST_CASE(statistics__to_text__no_commands__totals)
+{
+    statistics stats;
+    stats.unhandled();
+    stats.unanswered();
+    stats.unanswered();
+
+    const auto text = stats.to_text();
+    BOOST_REQUIRE(grouped(text));
+    BOOST_REQUIRE(contains(text,
+        "# TYPE bs_unhandled_total counter\nbs_unhandled_total 1\n"));
+    BOOST_REQUIRE(contains(text,
+        "# TYPE bs_unanswered_total counter\nbs_unanswered_total 2\n"));
+}
+
+BOOST_AUTO_TEST_CASE(statistics__to_text__commands__counters_grouped)
+{
+    statistics stats;
+    auto& first = stats.add("blockchain.fetch_history");
+    auto& second = stats.add("address.subscribe");
+    stats.receive(first, 10);
+    stats.receive(first, 20);
+    stats.receive(second, 5);
+
+    // Commands are ordered by name within each family.
+    const auto text = stats.to_text();
+    BOOST_REQUIRE(grouped(text));
+    BOOST_REQUIRE(contains(text,
+        "# TYPE bs_requests_total counter\n"
+        "bs_requests_total{command=\"address.subscribe\"} 1\n"
+        "bs_requests_total{command=\"blockchain.fetch_history\"} 2\n"));
+    BOOST_REQUIRE(contains(text,
+        "# TYPE bs_bytes_in_total counter\n"
+        "bs_bytes_in_total{command=\"address.subscribe\"} 5\n"
+        "bs_bytes_in_total{command=\"blockchain.fetch_history\"} 30\n"));
+}
+
+BOOST_AUTO_TEST_CASE(statistics__to_text__dispatched__latency_summary)
+{
+    statistics stats;
+    auto& command = stats.add("blockchain.fetch_history");
+    const auto timing = stats.receive(command, 0);
+    stats.dispatch(*timing);
+
+    const auto text = stats.to_text();
+    const std::string labels =
+        "{command=\"blockchain.fetch_history\",stage=\"queue\"";
+
+    BOOST_REQUIRE(grouped(text));
+    BOOST_REQUIRE(contains(text, "# TYPE bs_latency_microseconds summary\n"
+        "bs_latency_microseconds" + labels + ",quantile=\"0.5\"} "));
+    BOOST_REQUIRE(contains(text,
+        "bs_latency_microseconds" + labels + ",quantile=\"0.999\"} "));
+    BOOST_REQUIRE(contains(text,
+        "bs_latency_microseconds_count" + labels + "} 1\n"));
+    BOOST_REQUIRE(contains(text,
+        "# TYPE bs_latency_max_microseconds gauge\n"
+        "bs_latency_max_microseconds" + labels + "} "));
+
+    // The handler stage is not timed until a reply.
+    BOOST_REQUIRE(contains(text, "bs_latency_microseconds_count{command="
+        "\"blockchain.fetch_history\",stage=\"handler\"} 0\n"));
+}
+
+BOOST_AUTO_TEST_CASE(statistics__to_text__gauge__typed_value)
+{
+    statistics stats;
+    stats.add_gauge("transaction_cache_size", []() { return 42; });
+
+    const auto text = stats.to_text();
+    BOOST_REQUIRE(grouped(text));
+    BOOST_REQUIRE(contains(text, "# TYPE bs_transaction_cache_size gauge\n"
+        "bs_transaction_cache_size 42\n"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
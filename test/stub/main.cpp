@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <bitcoin/server.hpp>
+#include "stub_node.hpp"
+#include "synthetic_chain.hpp"
+
+BC_USE_LIBBITCOIN_MAIN
+
+using namespace bc;
+using namespace bc::server;
+
+typedef std::chrono::steady_clock stub_clock;
+
+#define BS_STUB_USAGE \
+    "Usage: libbitcoin_server_stub [options]\n" \
+    "Serves queries and subscriptions from a synthetic in-memory chain.\n\n" \
+    "  -e <endpoint>     The query endpoint, defaults to 'tcp://*:9091'.\n" \
+    "  -b <blocks>       The blocks generated at startup, defaults to 1000.\n" \
+    "  -t <count>        The transactions per block, defaults to 100.\n" \
+    "  -a <count>        The number of addresses, defaults to 100000.\n" \
+    "  -z <exponent>     The Zipf exponent of address popularity, 0 for\n" \
+    "                    uniform, defaults to 1.\n" \
+    "  -x <interval>     One in this many outputs is a stealth payment,\n" \
+    "                    0 for none, defaults to 100.\n" \
+    "  -d <us>           The simulated read latency, defaults to 0.\n" \
+    "  -n <threads>      The query threads, defaults to 4.\n" \
+    "  -r <seed>         The generator seed, defaults to 0.\n" \
+    "  -m <seconds>      Mine a block at this interval, defaults to 0 (off).\n" \
+    "  -p <rate>         Pool transactions per second, defaults to 0.\n"
+
+// The most popular addresses are listed as query targets.
+static constexpr size_t listed_addresses = 10;
+
+struct stub_arguments
+{
+    synthetic_chain_settings chain;
+    std::string endpoint = "tcp://*:9091";
+    uint32_t mine_seconds = 0;
+    uint32_t pool_rate = 0;
+};
+
+static bool parse(int argc, char* argv[], stub_arguments& out)
+{
+    for (auto arg = 1; arg < argc; ++arg)
+    {
+        const std::string option(argv[arg]);
+        if (arg + 1 >= argc)
+            return false;
+
+        const std::string value(argv[++arg]);
+        const auto number = std::strtoul(value.c_str(), nullptr, 10);
+
+        if (option == "-e")
+            out.endpoint = value;
+        else if (option == "-b")
+            out.chain.blocks = number;
+        else if (option == "-t")
+            out.chain.transactions_per_block = number;
+        else if (option == "-a")
+            out.chain.addresses = number;
+        else if (option == "-z")
+            out.chain.address_skew = std::atof(value.c_str());
+        else if (option == "-x")
+            out.chain.stealth_interval = number;
+        else if (option == "-d")
+            out.chain.read_delay_microseconds = number;
+        else if (option == "-n")
+            out.chain.threads = number;
+        else if (option == "-r")
+            out.chain.seed = number;
+        else if (option == "-m")
+            out.mine_seconds = number;
+        else if (option == "-p")
+            out.pool_rate = number;
+        else
+            return false;
+    }
+
+    return out.chain.addresses > 0 && out.chain.transactions_per_block > 0 &&
+        out.chain.threads > 0;
+}
+
+static bool stopped = false;
+static void interrupt_handler(int)
+{
+    stopped = true;
+}
+
+static configuration stub_configuration(const stub_arguments& arguments)
+{
+    auto config = server_node::defaults;
+    config.server.query_endpoint = config::endpoint(arguments.endpoint);
+    config.server.queries_enabled = true;
+    config.server.publisher_enabled = false;
+
+    // Notifications are suppressed below the last checkpoint.
+    config.chain.checkpoints.clear();
+    return config;
+}
+
+static console_result run(const stub_arguments& arguments,
+    std::ostream& output, std::ostream& error)
+{
+    const auto config = stub_configuration(arguments);
+
+    output << "Generating " << arguments.chain.blocks << " blocks..."
+        << std::endl;
+    stub_node node(config, arguments.chain);
+
+    output << "Most popular addresses:" << std::endl;
+    const auto& addresses = node.chain().addresses();
+    for (size_t index = 0; index < listed_addresses &&
+        index < addresses.size(); ++index)
+        output << "  " << wallet::payment_address(addresses[index], 0x00)
+            .encoded() << std::endl;
+
+    node.filters().load(node.blockchain());
+    node.headers().load(node.blockchain());
+
+    publisher publish(node, config.server);
+    request_worker worker(node.stats(), config.server);
+    subscribe_manager subscriber(node, config.server);
+    if (!worker.start())
+    {
+        error << "Query service failed to start." << std::endl;
+        return console_result::not_started;
+    }
+
+    attach_api(worker, node, subscriber, publish);
+    output << "Serving queries on " << arguments.endpoint
+        << ", press CTRL-C to stop." << std::endl;
+
+    signal(SIGTERM, interrupt_handler);
+    signal(SIGINT, interrupt_handler);
+
+    const auto mine_interval = std::chrono::seconds(arguments.mine_seconds);
+    const auto pool_interval = arguments.pool_rate == 0 ?
+        stub_clock::duration::max() :
+        stub_clock::duration(std::chrono::seconds(1)) / arguments.pool_rate;
+
+    auto mined = stub_clock::now();
+    auto pooled = stub_clock::now();
+    while (!stopped)
+    {
+        worker.update();
+        const auto now = stub_clock::now();
+
+        if (arguments.mine_seconds > 0 && now - mined >= mine_interval)
+        {
+            node.mine(1);
+            mined = now;
+        }
+
+        // Catch up on missed transactions after a long poll.
+        while (now - pooled >= pool_interval)
+        {
+            node.accept_transaction();
+            pooled += pool_interval;
+        }
+    }
+
+    if (!worker.stop())
+        error << "Query service failed to stop." << std::endl;
+
+    return console_result::okay;
+}
+
+/**
+ * Run a query server on a synthetic chain, for load testing without a
+ * database.
+ * @param argc  The number of elements in the argv array.
+ * @param argv  The array of arguments, including the process.
+ * @return      The numeric result to return via console exit.
+ */
+int bc::main(int argc, char* argv[])
+{
+    bc::set_utf8_stdio();
+
+    stub_arguments arguments;
+    if (!parse(argc, argv, arguments))
+    {
+        bc::cerr << BS_STUB_USAGE;
+        return console_result::failure;
+    }
+
+    return run(arguments, bc::cout, bc::cerr);
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "stub_node.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/server.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::blockchain;
+using std::placeholders::_1;
+using std::placeholders::_2;
+using std::placeholders::_3;
+using std::placeholders::_4;
+
+stub_node::stub_node(const configuration& config,
+    const synthetic_chain_settings& chain_settings)
+  : server_node(config), chain_(chain_settings)
+{
+    chain_.subscribe_reorganize(
+        std::bind(&stub_node::handle_reorganize,
+            this, _1, _2, _3, _4));
+}
+
+block_chain& stub_node::blockchain()
+{
+    return chain_;
+}
+
+synthetic_chain& stub_node::chain()
+{
+    return chain_;
+}
+
+void stub_node::mine(size_t count)
+{
+    // Notified through the reorganization subscription.
+    chain_.mine(count);
+}
+
+void stub_node::accept_transaction()
+{
+    const auto tx = chain_.make_transaction();
+    handle_tx_validated(code(), tx, tx.hash(), chain::index_list());
+}
+
+void stub_node::handle_reorganize(const code& ec, uint64_t fork_point,
+    const block_chain::list& new_blocks,
+    const block_chain::list& replaced_blocks)
+{
+    handle_new_blocks(ec, fork_point, new_blocks, replaced_blocks);
+
+    if (ec == bc::error::service_stopped)
+        return;
+
+    chain_.subscribe_reorganize(
+        std::bind(&stub_node::handle_reorganize,
+            this, _1, _2, _3, _4));
+}
+
+} // namespace server
+} // namespace libbitcoin
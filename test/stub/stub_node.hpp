@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_STUB_NODE_HPP
+#define LIBBITCOIN_SERVER_STUB_NODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/server.hpp>
+#include "synthetic_chain.hpp"
+
+namespace libbitcoin {
+namespace server {
+
+/**
+ * A server node whose block chain is a synthetic in-memory chain, for
+ * testing the query and subscription services without a database. The node
+ * is never started, so it has no peers and its memory pool stays empty.
+ */
+class stub_node
+  : public server_node
+{
+public:
+    stub_node(const configuration& config,
+        const synthetic_chain_settings& chain_settings);
+
+    blockchain::block_chain& blockchain() override;
+
+    synthetic_chain& chain();
+
+    /// Mine blocks, which are notified as the node notifies new blocks.
+    void mine(size_t count);
+
+    /// Notify a synthetic transaction as accepted to the memory pool.
+    void accept_transaction();
+
+private:
+    void handle_reorganize(const code& ec, uint64_t fork_point,
+        const blockchain::block_chain::list& new_blocks,
+        const blockchain::block_chain::list& replaced_blocks);
+
+    synthetic_chain chain_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
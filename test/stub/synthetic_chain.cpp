@@ -0,0 +1,575 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "synthetic_chain.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/thread.hpp>
+#include <bitcoin/node.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::chain;
+using namespace bc::wallet;
+
+typedef boost::shared_lock<boost::shared_mutex> shared_lock;
+typedef boost::unique_lock<boost::shared_mutex> unique_lock;
+
+static constexpr uint64_t coinbase_value = 50 * 100000000ull;
+static constexpr uint32_t block_interval_seconds = 600;
+
+static data_chunk random_data(size_t size, std::mt19937_64& random)
+{
+    data_chunk data(size);
+    for (auto& byte: data)
+        byte = static_cast<uint8_t>(random());
+
+    return data;
+}
+
+template <typename Array>
+static Array random_array(std::mt19937_64& random)
+{
+    Array out;
+    for (auto& byte: out)
+        byte = static_cast<uint8_t>(random());
+
+    return out;
+}
+
+static hash_digest merkle_root(const transaction::list& transactions)
+{
+    hash_list level;
+    for (const auto& tx: transactions)
+        level.push_back(tx.hash());
+
+    while (level.size() > 1)
+    {
+        if (level.size() % 2 != 0)
+            level.push_back(level.back());
+
+        hash_list next;
+        for (size_t index = 0; index < level.size(); index += 2)
+            next.push_back(bitcoin_hash(build_chunk(
+                { level[index], level[index + 1] })));
+
+        level.swap(next);
+    }
+
+    return level.empty() ? null_hash : level.front();
+}
+
+static std::vector<double> zipf_weights(uint32_t count, double exponent)
+{
+    std::vector<double> weights(count);
+    for (uint32_t rank = 0; rank < count; ++rank)
+        weights[rank] = 1.0 / std::pow(rank + 1.0, exponent);
+
+    return weights;
+}
+
+synthetic_chain::synthetic_chain(const synthetic_chain_settings& settings)
+  : settings_(settings),
+    pool_(settings.threads),
+    dispatch_(pool_),
+    random_(settings.seed),
+    outputs_(0)
+{
+    const auto weights = zipf_weights(settings.addresses,
+        settings.address_skew);
+    pick_address_ = std::discrete_distribution<uint32_t>(weights.begin(),
+        weights.end());
+
+    for (uint32_t address = 0; address < settings.addresses; ++address)
+        addresses_.push_back(random_array<short_hash>(random_));
+
+    // The genesis block is real, the rest are generated.
+    const auto genesis = std::make_shared<block>(mainnet_genesis_block());
+    blocks_.push_back(genesis);
+    heights_[genesis->header.hash()] = 0;
+    for (uint64_t position = 0; position < genesis->transactions.size();
+        ++position)
+        transactions_[genesis->transactions[position].hash()] =
+            { 0, position };
+
+    mine(settings.blocks);
+}
+
+synthetic_chain::~synthetic_chain()
+{
+    pool_.stop();
+    pool_.join();
+}
+
+block_chain::list synthetic_chain::mine(size_t count)
+{
+    list mined;
+    std::vector<reorganize_handler> handlers;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto fork_point = blocks_.size() - 1;
+    for (size_t number = 0; number < count; ++number)
+    {
+        const auto height = blocks_.size();
+        std::vector<generated> txs;
+        txs.push_back(make_coinbase(height));
+        while (txs.size() < settings_.transactions_per_block &&
+            !unspent_.empty())
+            txs.push_back(make_spend(true));
+
+        const auto mined_block = make_block(height, txs);
+        blocks_.push_back(mined_block);
+        mined.push_back(mined_block);
+        heights_[mined_block->header.hash()] = height;
+
+        for (uint64_t position = 0; position < txs.size(); ++position)
+            index(txs[position], height, position);
+
+        // Outputs are spendable from the next block.
+        for (const auto& item: txs)
+        {
+            const auto hash = item.tx.hash();
+            for (uint32_t output = 0; output < item.paid.size(); ++output)
+                unspent_.push_back({ { hash, output }, item.paid[output],
+                    item.tx.outputs[output].value });
+        }
+    }
+
+    // Reorganization subscriptions are one shot, as in the database.
+    handlers.swap(reorganize_handlers_);
+    lock.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: handlers)
+        dispatch_.unordered(handler, code(), fork_point, mined, list());
+
+    return mined;
+}
+
+transaction synthetic_chain::make_transaction()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    return unspent_.empty() ? make_coinbase(blocks_.size()).tx :
+        make_spend(false).tx;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+const std::vector<short_hash>& synthetic_chain::addresses() const
+{
+    return addresses_;
+}
+
+synthetic_chain::generated synthetic_chain::make_coinbase(uint64_t height)
+{
+    generated out;
+    out.tx.version = 1;
+    out.tx.locktime = 0;
+
+    transaction_input input;
+    input.previous_output.hash = null_hash;
+    input.previous_output.index = max_uint32;
+    input.script.operations.push_back({ opcode::special,
+        to_chunk(to_little_endian(static_cast<uint32_t>(height))) });
+    input.sequence = max_uint32;
+    out.tx.inputs.push_back(input);
+
+    const auto address = pick_address_(random_);
+    transaction_output output;
+    output.value = coinbase_value;
+    output.script.operations = operation::to_pay_key_hash_pattern(
+        addresses_[address]);
+    out.tx.outputs.push_back(output);
+    out.paid.push_back(address);
+    return out;
+}
+
+// Spends one or two outputs to two new outputs, the second the change.
+synthetic_chain::generated synthetic_chain::make_spend(bool consume)
+{
+    generated out;
+    out.tx.version = 1;
+    out.tx.locktime = 0;
+
+    const size_t inputs = unspent_.size() > 1 && random_() % 2 == 0 ? 2 : 1;
+    uint64_t value = 0;
+    for (size_t input = 0; input < inputs; ++input)
+    {
+        const auto pick = random_() % unspent_.size();
+        const auto spent = unspent_[pick];
+        if (consume)
+        {
+            unspent_[pick] = unspent_.back();
+            unspent_.pop_back();
+        }
+
+        // Signature and public key sized pushes.
+        transaction_input in;
+        in.previous_output = spent.point;
+        in.script.operations.push_back({ opcode::special,
+            random_data(72, random_) });
+        in.script.operations.push_back({ opcode::special,
+            random_data(33, random_) });
+        in.sequence = max_uint32;
+        out.tx.inputs.push_back(in);
+        out.spent.push_back(spent);
+        value += spent.value;
+
+        // Without consuming, the same output may not be picked twice.
+        if (!consume)
+            break;
+    }
+
+    const auto payment = value / 2;
+    for (const auto amount: { payment, value - payment })
+    {
+        const auto address = pick_address_(random_);
+        transaction_output output;
+        output.value = amount;
+        output.script.operations = operation::to_pay_key_hash_pattern(
+            addresses_[address]);
+        out.tx.outputs.push_back(output);
+        out.paid.push_back(address);
+    }
+
+    return out;
+}
+
+synthetic_chain::block_ptr synthetic_chain::make_block(uint64_t height,
+    std::vector<generated>& txs)
+{
+    const auto mined = std::make_shared<block>();
+    for (auto& item: txs)
+        mined->transactions.push_back(item.tx);
+
+    const auto& previous = blocks_.back()->header;
+    mined->header.version = 1;
+    mined->header.previous_block_hash = previous.hash();
+    mined->header.merkle = merkle_root(mined->transactions);
+    mined->header.timestamp = previous.timestamp + block_interval_seconds;
+    mined->header.bits = previous.bits;
+    mined->header.nonce = static_cast<uint32_t>(random_());
+    return mined;
+}
+
+// Histories are appended in height order, as the database returns them.
+void synthetic_chain::index(const generated& item, uint64_t height,
+    uint64_t position)
+{
+    const auto hash = item.tx.hash();
+    transactions_[hash] = { height, position };
+
+    for (uint32_t input = 0; input < item.spent.size(); ++input)
+    {
+        const auto& spent = item.spent[input];
+        const auto checksum = spend_checksum(spent.point);
+        spends_[checksum] = { hash, input };
+
+        history_row row;
+        row.kind = point_kind::spend;
+        row.point = { hash, input };
+        row.height = height;
+        row.previous_checksum = checksum;
+        histories_[addresses_[spent.address]].push_back(row);
+    }
+
+    for (uint32_t output = 0; output < item.paid.size(); ++output)
+    {
+        const auto& address = addresses_[item.paid[output]];
+
+        history_row row;
+        row.kind = point_kind::output;
+        row.point = { hash, output };
+        row.height = height;
+        row.value = item.tx.outputs[output].value;
+        histories_[address].push_back(row);
+
+        if (settings_.stealth_interval == 0 ||
+            ++outputs_ % settings_.stealth_interval != 0)
+            continue;
+
+        stealth_row stealth;
+        stealth.ephemkey = random_array<hash_digest>(random_);
+        stealth.address = address;
+        stealth.transaction_hash = hash;
+        const auto prefix = static_cast<uint32_t>(random_());
+        stealth_.push_back({ prefix, height, stealth });
+    }
+}
+
+void synthetic_chain::delay() const
+{
+    if (settings_.read_delay_microseconds > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            settings_.read_delay_microseconds));
+}
+
+bool synthetic_chain::start()
+{
+    return true;
+}
+
+bool synthetic_chain::stop()
+{
+    return true;
+}
+
+void synthetic_chain::store(block_ptr, store_block_handler handle_store)
+{
+    dispatch_.unordered(handle_store, error::operation_failed, block_info());
+}
+
+void synthetic_chain::import(block_ptr, import_block_handler handle_import)
+{
+    dispatch_.unordered(handle_import, error::operation_failed);
+}
+
+void synthetic_chain::fetch_block_header(uint64_t height,
+    block_header_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_block_header,
+        this, height, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_block_header(uint64_t height,
+    block_header_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    if (height >= blocks_.size())
+        handle_fetch(error::not_found, header());
+    else
+        handle_fetch(code(), blocks_[height]->header);
+}
+
+void synthetic_chain::fetch_block_header(const hash_digest& hash,
+    block_header_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_block_header_by_hash,
+        this, hash, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_block_header_by_hash(const hash_digest& hash,
+    block_header_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(hash);
+    if (it == heights_.end())
+        handle_fetch(error::not_found, header());
+    else
+        handle_fetch(code(), blocks_[it->second]->header);
+}
+
+void synthetic_chain::fetch_block_transaction_hashes(const hash_digest& hash,
+    transaction_hashes_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_block_transaction_hashes,
+        this, hash, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_block_transaction_hashes(
+    const hash_digest& hash, transaction_hashes_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(hash);
+    if (it == heights_.end())
+    {
+        handle_fetch(error::not_found, hash_list());
+        return;
+    }
+
+    hash_list hashes;
+    for (const auto& tx: blocks_[it->second]->transactions)
+        hashes.push_back(tx.hash());
+
+    handle_fetch(code(), hashes);
+}
+
+void synthetic_chain::fetch_block_height(const hash_digest& hash,
+    block_height_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_block_height,
+        this, hash, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_block_height(const hash_digest& hash,
+    block_height_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(hash);
+    if (it == heights_.end())
+        handle_fetch(error::not_found, 0);
+    else
+        handle_fetch(code(), it->second);
+}
+
+void synthetic_chain::fetch_last_height(last_height_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_last_height,
+        this, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_last_height(
+    last_height_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+    handle_fetch(code(), blocks_.size() - 1);
+}
+
+void synthetic_chain::fetch_transaction(const hash_digest& hash,
+    transaction_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_transaction,
+        this, hash, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_transaction(const hash_digest& hash,
+    transaction_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = transactions_.find(hash);
+    if (it == transactions_.end())
+    {
+        handle_fetch(error::not_found, transaction());
+        return;
+    }
+
+    const auto& location = it->second;
+    handle_fetch(code(),
+        blocks_[location.first]->transactions[location.second]);
+}
+
+void synthetic_chain::fetch_transaction_index(const hash_digest& hash,
+    transaction_index_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_transaction_index,
+        this, hash, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_transaction_index(const hash_digest& hash,
+    transaction_index_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = transactions_.find(hash);
+    if (it == transactions_.end())
+        handle_fetch(error::not_found, 0, 0);
+    else
+        handle_fetch(code(), it->second.first, it->second.second);
+}
+
+void synthetic_chain::fetch_spend(const output_point& outpoint,
+    spend_fetch_handler handle_fetch)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_spend,
+        this, outpoint, handle_fetch);
+}
+
+void synthetic_chain::do_fetch_spend(const output_point& outpoint,
+    spend_fetch_handler handle_fetch)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    const auto it = spends_.find(spend_checksum(outpoint));
+    if (it == spends_.end())
+        handle_fetch(error::unspent_output, input_point());
+    else
+        handle_fetch(code(), it->second);
+}
+
+void synthetic_chain::fetch_history(const payment_address& address,
+    history_fetch_handler handle_fetch, const uint64_t from_height)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_history,
+        this, address, handle_fetch, from_height);
+}
+
+void synthetic_chain::do_fetch_history(const payment_address& address,
+    history_fetch_handler handle_fetch, uint64_t from_height)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    history rows;
+    const auto it = histories_.find(address.hash());
+    if (it != histories_.end())
+        for (const auto& row: it->second)
+            if (row.height >= from_height)
+                rows.push_back(row);
+
+    handle_fetch(code(), rows);
+}
+
+void synthetic_chain::fetch_stealth(const binary_type& prefix,
+    stealth_fetch_handler handle_fetch, const uint64_t from_height)
+{
+    dispatch_.unordered(&synthetic_chain::do_fetch_stealth,
+        this, prefix, handle_fetch, from_height);
+}
+
+void synthetic_chain::do_fetch_stealth(const binary_type& prefix,
+    stealth_fetch_handler handle_fetch, uint64_t from_height)
+{
+    delay();
+    shared_lock lock(mutex_);
+
+    stealth rows;
+    for (const auto& entry: stealth_)
+        if (entry.height >= from_height && prefix.is_prefix_of(entry.prefix))
+            rows.push_back(entry.row);
+
+    handle_fetch(code(), rows);
+}
+
+void synthetic_chain::subscribe_reorganize(
+    reorganize_handler handle_reorganize)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+    reorganize_handlers_.push_back(handle_reorganize);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace server
+} // namespace libbitcoin
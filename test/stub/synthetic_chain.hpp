@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_SYNTHETIC_CHAIN_HPP
+#define LIBBITCOIN_SERVER_SYNTHETIC_CHAIN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/thread.hpp>
+#include <bitcoin/node.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+struct synthetic_chain_settings
+{
+    /// The blocks generated on construction, after the genesis block.
+    uint32_t blocks = 1000;
+
+    /// The transactions of each generated block, including the coinbase.
+    uint32_t transactions_per_block = 100;
+
+    /// The number of distinct addresses paid by the generated outputs.
+    uint32_t addresses = 100000;
+
+    /// The Zipf exponent of the choice of address for each output, so
+    /// history sizes follow a power law. Zero is a uniform choice.
+    double address_skew = 1.0;
+
+    /// One in this many outputs is also a stealth payment, zero for none.
+    uint32_t stealth_interval = 100;
+
+    /// The simulated read latency of each query.
+    uint32_t read_delay_microseconds = 0;
+
+    /// The threads answering queries.
+    uint32_t threads = 4;
+
+    /// The seed of the generator, the same seed gives the same chain.
+    uint32_t seed = 0;
+};
+
+/**
+ * An in-memory block chain of synthetic transactions for testing and load
+ * testing the server without a database.
+ *
+ * Each block has a coinbase, and transactions that spend one or two random
+ * unspent outputs to two new outputs. Outputs pay addresses chosen from a
+ * Zipf distribution, so a few addresses have long histories and most have
+ * short ones. Queries are answered on the chain's own threadpool, as the
+ * database does. This class is thread safe.
+ */
+class synthetic_chain
+  : public blockchain::block_chain
+{
+public:
+    typedef std::shared_ptr<chain::block> block_ptr;
+
+    synthetic_chain(const synthetic_chain_settings& settings);
+    ~synthetic_chain();
+
+    /// Generate and append blocks, returning them for notification.
+    list mine(size_t count);
+
+    /// Generate a transaction spending current unspent outputs, which is
+    /// not added to the chain.
+    chain::transaction make_transaction();
+
+    /// The addresses ordered from the most to the least frequently paid.
+    const std::vector<short_hash>& addresses() const;
+
+    // block_chain interface.
+    bool start() override;
+    bool stop() override;
+    void store(block_ptr block, store_block_handler handle_store) override;
+    void import(block_ptr block, import_block_handler handle_import) override;
+    void fetch_block_header(uint64_t height,
+        block_header_fetch_handler handle_fetch) override;
+    void fetch_block_header(const hash_digest& hash,
+        block_header_fetch_handler handle_fetch) override;
+    void fetch_block_transaction_hashes(const hash_digest& hash,
+        transaction_hashes_fetch_handler handle_fetch) override;
+    void fetch_block_height(const hash_digest& hash,
+        block_height_fetch_handler handle_fetch) override;
+    void fetch_last_height(last_height_fetch_handler handle_fetch) override;
+    void fetch_transaction(const hash_digest& hash,
+        transaction_fetch_handler handle_fetch) override;
+    void fetch_transaction_index(const hash_digest& hash,
+        transaction_index_fetch_handler handle_fetch) override;
+    void fetch_spend(const chain::output_point& outpoint,
+        spend_fetch_handler handle_fetch) override;
+    void fetch_history(const wallet::payment_address& address,
+        history_fetch_handler handle_fetch,
+        const uint64_t from_height=0) override;
+    void fetch_stealth(const binary_type& prefix,
+        stealth_fetch_handler handle_fetch,
+        const uint64_t from_height=0) override;
+    void subscribe_reorganize(reorganize_handler handle_reorganize) override;
+
+private:
+    struct unspent
+    {
+        chain::output_point point;
+        uint32_t address;
+        uint64_t value;
+    };
+
+    // A generated transaction with the outputs it spends and the addresses
+    // its outputs pay.
+    struct generated
+    {
+        chain::transaction tx;
+        std::vector<unspent> spent;
+        std::vector<uint32_t> paid;
+    };
+
+    struct stealth_entry
+    {
+        uint32_t prefix;
+        uint64_t height;
+        stealth_row row;
+    };
+
+    // The height of a transaction and its index in the block.
+    typedef std::pair<uint64_t, uint64_t> location;
+
+    void delay() const;
+    generated make_coinbase(uint64_t height);
+    generated make_spend(bool consume);
+    block_ptr make_block(uint64_t height, std::vector<generated>& txs);
+    void index(const generated& item, uint64_t height, uint64_t position);
+
+    void do_fetch_block_header(uint64_t height,
+        block_header_fetch_handler handle_fetch);
+    void do_fetch_block_header_by_hash(const hash_digest& hash,
+        block_header_fetch_handler handle_fetch);
+    void do_fetch_block_transaction_hashes(const hash_digest& hash,
+        transaction_hashes_fetch_handler handle_fetch);
+    void do_fetch_block_height(const hash_digest& hash,
+        block_height_fetch_handler handle_fetch);
+    void do_fetch_last_height(last_height_fetch_handler handle_fetch);
+    void do_fetch_transaction(const hash_digest& hash,
+        transaction_fetch_handler handle_fetch);
+    void do_fetch_transaction_index(const hash_digest& hash,
+        transaction_index_fetch_handler handle_fetch);
+    void do_fetch_spend(const chain::output_point& outpoint,
+        spend_fetch_handler handle_fetch);
+    void do_fetch_history(const wallet::payment_address& address,
+        history_fetch_handler handle_fetch, uint64_t from_height);
+    void do_fetch_stealth(const binary_type& prefix,
+        stealth_fetch_handler handle_fetch, uint64_t from_height);
+
+    const synthetic_chain_settings settings_;
+    threadpool pool_;
+    dispatcher dispatch_;
+
+    // Generator state, guarded by the unique lock of the mutex.
+    std::mt19937_64 random_;
+    std::discrete_distribution<uint32_t> pick_address_;
+    std::vector<short_hash> addresses_;
+    std::vector<unspent> unspent_;
+    uint64_t outputs_;
+
+    // Indexes, read under the shared lock of the mutex. Spends are keyed
+    // by the spend checksum of the spent output.
+    std::vector<block_ptr> blocks_;
+    std::unordered_map<hash_digest, uint64_t> heights_;
+    std::unordered_map<hash_digest, location> transactions_;
+    std::unordered_map<uint64_t, chain::input_point> spends_;
+    std::unordered_map<short_hash, history> histories_;
+    std::vector<stealth_entry> stealth_;
+    std::vector<reorganize_handler> reorganize_handlers_;
+    mutable boost::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
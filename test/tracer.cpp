@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc::server;
+using boost::property_tree::ptree;
+
+typedef request_trace::point point;
+
+struct tracer_fixture
+{
+    tracer_fixture()
+      : path(boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("tracer-%%%%-%%%%.json"))
+    {
+    }
+
+    ~tracer_fixture()
+    {
+        boost::filesystem::remove(path);
+    }
+
+    settings make_settings(uint32_t interval) const
+    {
+        auto settings = server_node::defaults.server;
+        settings.trace_sample_interval = interval;
+        settings.trace_file = path;
+        return settings;
+    }
+
+    // The events of the trace file, which must be a valid JSON array.
+    ptree read_events() const
+    {
+        ptree events;
+        boost::property_tree::read_json(path.string(), events);
+        return events;
+    }
+
+    const boost::filesystem::path path;
+};
+
+static void stamp(request_trace& trace, point at)
+{
+    trace.stamp(at);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+BOOST_FIXTURE_TEST_SUITE(tracer_tests, tracer_fixture)
+
+BOOST_AUTO_TEST_CASE(request_trace__stamp__twice__first_kept)
+{
+    request_trace trace(1, "blockchain.fetch_history", 42);
+    BOOST_REQUIRE_EQUAL(trace.time(point::receive), 0u);
+
+    stamp(trace, point::receive);
+    const auto first = trace.time(point::receive);
+    BOOST_REQUIRE_NE(first, 0u);
+
+    trace.stamp(point::receive);
+    BOOST_REQUIRE_EQUAL(trace.time(point::receive), first);
+}
+
+BOOST_AUTO_TEST_CASE(tracer__sample__zero_interval__disabled)
+{
+    const auto settings = make_settings(0);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+
+    for (size_t request = 0; request < 10; ++request)
+        BOOST_REQUIRE(!trace.sample("blockchain.fetch_history", 0));
+
+    BOOST_REQUIRE(!boost::filesystem::exists(path));
+}
+
+BOOST_AUTO_TEST_CASE(tracer__sample__not_started__none)
+{
+    const auto settings = make_settings(1);
+    tracer trace(settings);
+    BOOST_REQUIRE(!trace.sample("blockchain.fetch_history", 0));
+}
+
+BOOST_AUTO_TEST_CASE(tracer__sample__interval__one_in_interval)
+{
+    const auto settings = make_settings(3);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+
+    // The first request of each interval is sampled, with a new id.
+    for (uint32_t request = 0; request < 9; ++request)
+    {
+        const auto sampled = trace.sample("blockchain.fetch_history",
+            request);
+
+        BOOST_REQUIRE_EQUAL(static_cast<bool>(sampled), request % 3 == 0);
+        if (sampled)
+        {
+            BOOST_REQUIRE_EQUAL(sampled->id(), request / 3 + 1);
+            BOOST_REQUIRE_EQUAL(sampled->request_id(), request);
+            BOOST_REQUIRE_EQUAL(sampled->command(),
+                "blockchain.fetch_history");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tracer__write__no_events__empty_array)
+{
+    const auto settings = make_settings(1);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+    trace.stop();
+
+    BOOST_REQUIRE(read_events().empty());
+}
+
+BOOST_AUTO_TEST_CASE(tracer__write__not_received__no_events)
+{
+    const auto settings = make_settings(1);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+
+    const auto sampled = trace.sample("blockchain.fetch_history", 7);
+    sampled->stamp(point::dispatch);
+    trace.write(*sampled);
+    trace.stop();
+
+    BOOST_REQUIRE(read_events().empty());
+}
+
+BOOST_AUTO_TEST_CASE(tracer__write__stamped__stage_and_request_events)
+{
+    const auto settings = make_settings(1);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+
+    // The database and dequeue points are not stamped, so their stages
+    // are merged into the stages that follow.
+    const auto sampled = trace.sample("blockchain.fetch_history", 7);
+    stamp(*sampled, point::receive);
+    stamp(*sampled, point::dispatch);
+    stamp(*sampled, point::reply);
+    stamp(*sampled, point::send);
+    trace.write(*sampled);
+    trace.stop();
+
+    const auto events = read_events();
+    BOOST_REQUIRE_EQUAL(events.size(), 4u);
+
+    const std::string names[] =
+    {
+        "queue", "serialize", "send", "blockchain.fetch_history"
+    };
+
+    const point starts[] =
+    {
+        point::receive, point::dispatch, point::reply, point::receive
+    };
+
+    const point ends[] =
+    {
+        point::dispatch, point::reply, point::send, point::send
+    };
+
+    size_t index = 0;
+    for (const auto& item: events)
+    {
+        const auto& event = item.second;
+        const auto start = sampled->time(starts[index]);
+        const auto end = sampled->time(ends[index]);
+
+        BOOST_REQUIRE_EQUAL(event.get<std::string>("name"), names[index]);
+        BOOST_REQUIRE_EQUAL(event.get<std::string>("cat"),
+            "blockchain.fetch_history");
+        BOOST_REQUIRE_EQUAL(event.get<std::string>("ph"), "X");
+        BOOST_REQUIRE_EQUAL(event.get<uint64_t>("ts"), start);
+        BOOST_REQUIRE_EQUAL(event.get<uint64_t>("dur"), end - start);
+        BOOST_REQUIRE_EQUAL(event.get<uint32_t>("pid"), 1u);
+        BOOST_REQUIRE_EQUAL(event.get<uint64_t>("tid"), sampled->id());
+        BOOST_REQUIRE_EQUAL(event.get<uint32_t>("args.id"), 7u);
+        ++index;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tracer__write__client_command__escaped)
+{
+    const auto settings = make_settings(1);
+    tracer trace(settings);
+    BOOST_REQUIRE(trace.start());
+
+    // An unknown command is traced as sent by the client.
+    const std::string command = "bad\"command\\\n";
+    const auto sampled = trace.sample(command, 7);
+    sampled->stamp(point::receive);
+    trace.write(*sampled);
+    trace.stop();
+
+    const auto events = read_events();
+    BOOST_REQUIRE_EQUAL(events.size(), 1u);
+    BOOST_REQUIRE_EQUAL(events.front().second.get<std::string>("name"),
+        command);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin-server.
+ *
+ * libbitcoin-server is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::server;
+using namespace bc::wallet;
+
+static short_hash make_hash(uint8_t value)
+{
+    short_hash hash;
+    hash.fill(value);
+    return hash;
+}
+
+// A transaction paying the address of the value, distinct per value.
+static transaction make_transaction(uint8_t value)
+{
+    transaction tx;
+    tx.version = 1;
+    tx.locktime = value;
+
+    transaction_input input;
+    input.previous_output.hash = null_hash;
+    input.previous_output.index = value;
+    input.sequence = max_uint32;
+    tx.inputs.push_back(input);
+
+    transaction_output output;
+    output.value = value;
+    output.script.operations = operation::to_pay_key_hash_pattern(
+        make_hash(value));
+    tx.outputs.push_back(output);
+    return tx;
+}
+
+BOOST_AUTO_TEST_SUITE(transaction_cache_tests)
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__miss__analyzed)
+{
+    transaction_cache cache(10);
+    const auto tx = make_transaction(1);
+
+    data_chunk buffer;
+    const auto analysis = cache.get(tx, buffer);
+    BOOST_REQUIRE(analysis);
+    BOOST_REQUIRE(analysis->hash == tx.hash());
+    BOOST_REQUIRE(analysis->data == tx.to_data());
+    BOOST_REQUIRE_EQUAL(analysis->output_addresses.size(), 1u);
+    BOOST_REQUIRE(analysis->output_addresses.front().hash() == make_hash(1));
+    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__hit__same_analysis)
+{
+    transaction_cache cache(10);
+    const auto tx = make_transaction(1);
+
+    // The pool path provides the hash, the block path computes it.
+    data_chunk buffer;
+    const auto first = cache.get(tx, tx.hash());
+    const auto second = cache.get(tx, buffer);
+    BOOST_REQUIRE(first == second);
+    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__reused_buffer__distinct_analyses)
+{
+    transaction_cache cache(10);
+    const auto tx1 = make_transaction(1);
+    const auto tx2 = make_transaction(2);
+
+    data_chunk buffer;
+    const auto first = cache.get(tx1, buffer);
+    const auto second = cache.get(tx2, buffer);
+    BOOST_REQUIRE(first->hash == tx1.hash());
+    BOOST_REQUIRE(first->data == tx1.to_data());
+    BOOST_REQUIRE(second->hash == tx2.hash());
+    BOOST_REQUIRE(second->data == tx2.to_data());
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__over_capacity__least_recent_evicted)
+{
+    transaction_cache cache(2);
+    const auto tx1 = make_transaction(1);
+    const auto tx2 = make_transaction(2);
+    const auto tx3 = make_transaction(3);
+
+    data_chunk buffer;
+    cache.get(tx1, buffer);
+    cache.get(tx2, buffer);
+
+    // Using the first makes the second the least recently used.
+    cache.get(tx1, buffer);
+    cache.get(tx3, buffer);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 3u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1u);
+
+    cache.get(tx1, buffer);
+    cache.get(tx3, buffer);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 3u);
+
+    cache.get(tx2, buffer);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 4u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__zero_capacity__not_stored)
+{
+    transaction_cache cache(0);
+    const auto tx = make_transaction(1);
+
+    data_chunk buffer;
+    const auto first = cache.get(tx, buffer);
+    const auto second = cache.get(tx, buffer);
+    BOOST_REQUIRE(first != second);
+    BOOST_REQUIRE(first->hash == second->hash);
+    BOOST_REQUIRE_EQUAL(cache.size(), 0u);
+    BOOST_REQUIRE_EQUAL(cache.misses(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
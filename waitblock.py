@@ -4,7 +4,7 @@ import struct
 
 context = zmq.Context(1)
 socket = context.socket(zmq.SUB)
-socket.connect("tcp://localhost:9093")
+socket.connect("tcp://localhost:9095")
 socket.setsockopt(zmq.SUBSCRIBE, "")
 height = struct.unpack("<I", socket.recv())[0]
 blk_hash = socket.recv().encode("hex")